@@ -2,46 +2,1650 @@
 #define BIGINT_H
 
 #include<string>
+#include<vector>
+#include<cstdint>
+#include<cstddef>
+#include<algorithm>
+#include<iterator>
+#include<memory>
+#include<stdexcept>
+#include<type_traits>
+#include<istream>
+#include<ostream>
+#include<locale>
+#include<utility>
+#include<numeric>
+#include<cmath>
+#include<cstring>
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<exception>
+#include<functional>
+#include<mutex>
+#include<thread>
+#if !defined(BIGINT_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BIGINT_SIMD 1
+#include<immintrin.h>
+#else
+#define BIGINT_SIMD 0
+#endif
 using std::string;
 
 namespace gasper {
 
-	template<unsigned base> 
+	/**
+	*	Low level kernels over little-endian arrays of 32-bit limbs.
+	*	Output arrays may alias the first input only where noted.
+	*/
+	namespace detail {
+
+		typedef std::uint32_t limb_t;
+		typedef std::uint64_t dlimb_t;
+		const unsigned limb_bits = 32;
+		const std::size_t burnikel_ziegler_threshold = 128;
+
+		inline std::size_t normalized_size(const limb_t* a, std::size_t n)
+		{
+			while (n && !a[n - 1]) --n;
+			return n;
+		}
+
+		inline int cmp(const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			if (an != bn) return an < bn ? -1 : 1;
+			while (an--)
+				if (a[an] != b[an]) return a[an] < b[an] ? -1 : 1;
+			return 0;
+		}
+
+		// r = a + b, r may alias a
+		inline limb_t add_1(limb_t* r, const limb_t* a, std::size_t n, limb_t b)
+		{
+			std::size_t i = 0;
+			for (; i < n && b; ++i)
+			{
+				r[i] = a[i] + b;
+				b = r[i] < b;
+			}
+			if (r != a) std::copy(a + i, a + n, r + i);
+			return b;
+		}
+
+		// r = a + b, r may alias a or b
+		inline limb_t add_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			dlimb_t c = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				c += dlimb_t(a[i]) + b[i];
+				r[i] = limb_t(c);
+				c >>= limb_bits;
+			}
+			return limb_t(c);
+		}
+
+		// r = a - b, r may alias a
+		inline limb_t sub_1(limb_t* r, const limb_t* a, std::size_t n, limb_t b)
+		{
+			std::size_t i = 0;
+			for (; i < n && b; ++i)
+			{
+				limb_t t = a[i];
+				r[i] = t - b;
+				b = t < b;
+			}
+			if (r != a) std::copy(a + i, a + n, r + i);
+			return b;
+		}
+
+		// r = a - b, r may alias a or b
+		inline limb_t sub_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			limb_t borrow = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				dlimb_t d = dlimb_t(a[i]) - b[i] - borrow;
+				r[i] = limb_t(d);
+				borrow = limb_t(d >> limb_bits) & 1;
+			}
+			return borrow;
+		}
+
+#if BIGINT_SIMD
+		/**
+		*	Vector add/sub with carry lookahead. A lane generates a carry when its sum
+		*	wraps (borrow: a < b) and propagates one when its sum is all ones (borrow:
+		*	a == b). For lane masks G and P, ((G << 1) + P + carry) ^ P has bit i set
+		*	iff lane i takes a carry in, the bit above the last lane is the carry out.
+		*/
+		template<bool subtract>
+		__attribute__((target("avx2"))) limb_t addsub_n_avx2(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			const __m256i ones = _mm256_set1_epi32(-1), bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+			unsigned carry = 0;
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+			{
+				const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+				const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+				const __m256i z = subtract ? _mm256_sub_epi32(x, y) : _mm256_add_epi32(x, y);
+				const __m256i noWrap = subtract ? _mm256_cmpeq_epi32(_mm256_max_epu32(x, y), x) : _mm256_cmpeq_epi32(_mm256_max_epu32(x, z), z);
+				const __m256i full = _mm256_cmpeq_epi32(z, subtract ? _mm256_setzero_si256() : ones);
+				const unsigned g = ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(noWrap))) & 0xff;
+				const unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(full));
+				const unsigned c = ((g << 1) + p + carry) ^ p;
+				const __m256i in = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(c)), bits), bits);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), subtract ? _mm256_add_epi32(z, in) : _mm256_sub_epi32(z, in));
+				carry = c >> 8;
+			}
+			const std::size_t rest = n - i;
+			if (subtract) return sub_n_scalar(r + i, a + i, b + i, rest) | sub_1(r + i, r + i, rest, carry);
+			return add_n_scalar(r + i, a + i, b + i, rest) | add_1(r + i, r + i, rest, carry);
+		}
+
+		template<bool subtract>
+		__attribute__((target("sse4.1"))) limb_t addsub_n_sse41(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			const __m128i ones = _mm_set1_epi32(-1), bits = _mm_setr_epi32(1, 2, 4, 8);
+			unsigned carry = 0;
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				const __m128i z = subtract ? _mm_sub_epi32(x, y) : _mm_add_epi32(x, y);
+				const __m128i noWrap = subtract ? _mm_cmpeq_epi32(_mm_max_epu32(x, y), x) : _mm_cmpeq_epi32(_mm_max_epu32(x, z), z);
+				const __m128i full = _mm_cmpeq_epi32(z, subtract ? _mm_setzero_si128() : ones);
+				const unsigned g = ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(noWrap))) & 0xf;
+				const unsigned p = _mm_movemask_ps(_mm_castsi128_ps(full));
+				const unsigned c = ((g << 1) + p + carry) ^ p;
+				const __m128i in = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(int(c)), bits), bits);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), subtract ? _mm_add_epi32(z, in) : _mm_sub_epi32(z, in));
+				carry = c >> 4;
+			}
+			const std::size_t rest = n - i;
+			if (subtract) return sub_n_scalar(r + i, a + i, b + i, rest) | sub_1(r + i, r + i, rest, carry);
+			return add_n_scalar(r + i, a + i, b + i, rest) | add_1(r + i, r + i, rest, carry);
+		}
+#endif
+
+		typedef limb_t (*addsub_n_kernel)(limb_t*, const limb_t*, const limb_t*, std::size_t);
+
+		// picks the widest kernel the running CPU supports
+		template<bool subtract>
+		inline addsub_n_kernel select_addsub_n()
+		{
+#if BIGINT_SIMD
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) return addsub_n_avx2<subtract>;
+			if (__builtin_cpu_supports("sse4.1")) return addsub_n_sse41<subtract>;
+#endif
+			return subtract ? sub_n_scalar : add_n_scalar;
+		}
+
+		const std::size_t addsub_simd_threshold = 16;
+
+		// r = a + b, r may alias a or b
+		inline limb_t add_n(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			if (n < addsub_simd_threshold) return add_n_scalar(r, a, b, n);
+			static const addsub_n_kernel kernel = select_addsub_n<false>();
+			return kernel(r, a, b, n);
+		}
+
+		// r = a - b, r may alias a or b
+		inline limb_t sub_n(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n)
+		{
+			if (n < addsub_simd_threshold) return sub_n_scalar(r, a, b, n);
+			static const addsub_n_kernel kernel = select_addsub_n<true>();
+			return kernel(r, a, b, n);
+		}
+
+		// r = a + b with an >= bn, r may alias a
+		inline limb_t add(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			return add_1(r + bn, a + bn, an - bn, add_n(r, a, b, bn));
+		}
+
+		// r = a - b with an >= bn, r may alias a
+		inline limb_t sub(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			return sub_1(r + bn, a + bn, an - bn, sub_n(r, a, b, bn));
+		}
+
+		// r = a * m, r may alias a
+		inline limb_t mul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t m)
+		{
+			dlimb_t c = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				c += dlimb_t(a[i]) * m;
+				r[i] = limb_t(c);
+				c >>= limb_bits;
+			}
+			return limb_t(c);
+		}
+
+		// r += a * m
+		inline limb_t addmul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t m)
+		{
+			dlimb_t c = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				c += dlimb_t(a[i]) * m + r[i];
+				r[i] = limb_t(c);
+				c >>= limb_bits;
+			}
+			return limb_t(c);
+		}
+
+		// r -= a * m
+		inline limb_t submul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t m)
+		{
+			dlimb_t c = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				c += dlimb_t(a[i]) * m;
+				limb_t lo = limb_t(c);
+				c >>= limb_bits;
+				if (r[i] < lo) ++c;
+				r[i] -= lo;
+			}
+			return limb_t(c);
+		}
+
+		// q = a / d, returns a % d, q may alias a
+		inline limb_t divrem_1(limb_t* q, const limb_t* a, std::size_t n, limb_t d)
+		{
+			dlimb_t r = 0;
+			while (n--)
+			{
+				r = (r << limb_bits) | a[n];
+				q[n] = limb_t(r / d);
+				r %= d;
+			}
+			return limb_t(r);
+		}
+
+		constexpr unsigned leading_zeros(limb_t x)
+		{
+			unsigned n = 0;
+			for (limb_t mask = limb_t(1) << (limb_bits - 1); mask && !(x & mask); mask >>= 1) ++n;
+			return n;
+		}
+
+		// r = a << s for s < limb_bits, returns the bits shifted out, r may alias a
+		inline limb_t lshift(limb_t* r, const limb_t* a, std::size_t n, unsigned s)
+		{
+			if (!n) return 0;
+			if (!s)
+			{
+				std::copy_backward(a, a + n, r + n);
+				return 0;
+			}
+			const limb_t out = a[n - 1] >> (limb_bits - s);
+			for (std::size_t i = n - 1; i; --i)
+				r[i] = (a[i] << s) | (a[i - 1] >> (limb_bits - s));
+			r[0] = a[0] << s;
+			return out;
+		}
+
+		// r = a >> s for s < limb_bits, r may alias a
+		inline void rshift(limb_t* r, const limb_t* a, std::size_t n, unsigned s)
+		{
+			if (!s)
+			{
+				std::copy(a, a + n, r);
+				return;
+			}
+			for (std::size_t i = 0; i + 1 < n; ++i)
+				r[i] = (a[i] >> s) | (a[i + 1] << (limb_bits - s));
+			if (n) r[n - 1] = a[n - 1] >> s;
+		}
+
+		/**
+		*	Bump allocator behind BigIntArena. Memory is handed out from large
+		*	chunks; freeing the most recent allocation pops it again, so the nested
+		*	scratch buffers of the kernels reuse the same space, and anything else is
+		*	reclaimed by reset().
+		*/
+		class arena
+		{
+		public:
+			explicit arena(std::size_t chunkLimbs) : chunk_limbs(std::max<std::size_t>(chunkLimbs, 1)) { }
+
+			limb_t* allocate(std::size_t n)
+			{
+				while (current < chunks.size() && chunks[current].used + n > chunks[current].size) ++current;
+				if (current == chunks.size())
+				{
+					const std::size_t size = std::max(n, chunk_limbs);
+					chunks.push_back(chunk{ std::unique_ptr<limb_t[]>(new limb_t[size]), size, 0 });
+				}
+				chunk& c = chunks[current];
+				limb_t* result = c.data.get() + c.used;
+				c.used += n;
+				return result;
+			}
+
+			void deallocate(limb_t* p, std::size_t n)
+			{
+				if (current == chunks.size()) return;
+				chunk& c = chunks[current];
+				if (p + n != c.data.get() + c.used) return;
+				c.used -= n;
+				while (current && !chunks[current].used) --current;
+			}
+
+			void reset()
+			{
+				for (chunk& c : chunks) c.used = 0;
+				current = 0;
+			}
+
+		private:
+			struct chunk
+			{
+				std::unique_ptr<limb_t[]> data;
+				std::size_t size, used;
+			};
+			std::vector<chunk> chunks;
+			std::size_t chunk_limbs, current = 0;
+		};
+
+		inline arena*& current_arena()
+		{
+			static thread_local arena* instance = nullptr;
+			return instance;
+		}
+
+		// uninitialized temporary limbs, carved from the active arena if there is one
+		class scratch_buffer
+		{
+		public:
+			explicit scratch_buffer(std::size_t n) : owner(current_arena()), ptr(owner ? owner->allocate(n) : new limb_t[n]), len(n) { }
+			scratch_buffer(scratch_buffer&& other) noexcept : owner(other.owner), ptr(other.ptr), len(other.len) { other.ptr = nullptr; }
+			scratch_buffer(const scratch_buffer&) = delete;
+			scratch_buffer& operator=(const scratch_buffer&) = delete;
+			~scratch_buffer()
+			{
+				if (!ptr) return;
+				if (owner) owner->deallocate(ptr, len);
+				else delete[] ptr;
+			}
+
+			inline limb_t* data() const { return ptr; }
+			inline std::size_t size() const { return len; }
+			inline limb_t& operator[](std::size_t i) const { return ptr[i]; }
+
+		private:
+			arena* owner;
+			limb_t* ptr;
+			std::size_t len;
+		};
+
+		/**
+		*	LIFO scratch space for the recursive kernels. Blocks are never moved or
+		*	freed before the stack itself, so a buffer taken by one recursion level
+		*	stays valid while deeper levels take and release their own.
+		*/
+		class scratch_stack
+		{
+		public:
+			explicit scratch_stack(std::size_t hint) : hint(hint) { }
+			~scratch_stack() { while (!blocks.empty()) blocks.pop_back(); }
+
+			limb_t* take(std::size_t n)
+			{
+				while (current < blocks.size() && used + n > blocks[current].size())
+				{
+					++current;
+					used = 0;
+				}
+				if (current == blocks.size())
+					blocks.emplace_back(std::max(n, blocks.empty() ? hint : 2 * blocks.back().size()));
+				limb_t* result = blocks[current].data() + used;
+				used += n;
+				return result;
+			}
+
+		private:
+			friend class scratch_frame;
+			std::vector<scratch_buffer> blocks;
+			std::size_t hint, current = 0, used = 0;
+		};
+
+		// releases everything taken from a scratch_stack during its lifetime
+		class scratch_frame
+		{
+		public:
+			explicit scratch_frame(scratch_stack& s) : stack(s), current(s.current), used(s.used) { }
+			~scratch_frame() { stack.current = current; stack.used = used; }
+
+		private:
+			scratch_stack& stack;
+			const std::size_t current, used;
+		};
+
+		/**
+		*	Worker threads shared by the parallel kernels. A thread waiting on a
+		*	task_group runs queued tasks itself, newest first, while idle workers
+		*	take the oldest and largest ones, so nested groups cannot starve the pool.
+		*/
+		class thread_pool
+		{
+		public:
+			static thread_pool& instance()
+			{
+				static thread_pool pool;
+				return pool;
+			}
+			~thread_pool() { stop(); }
+
+			inline unsigned threads() const { return count.load(std::memory_order_relaxed); }
+
+			void set_threads(unsigned n)
+			{
+				if (!n) n = std::max(1u, std::thread::hardware_concurrency());
+				stop();
+				closing = false;
+				count = n;
+				for (unsigned i = 1; i < n; ++i) workers.emplace_back([this] { work(); });
+			}
+
+			void push(std::function<void()> task)
+			{
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					tasks.push_back(std::move(task));
+				}
+				wake.notify_one();
+			}
+
+			// runs the newest queued task on the calling thread, if there is one
+			bool run_one()
+			{
+				std::function<void()> task;
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					if (tasks.empty()) return false;
+					task = std::move(tasks.back());
+					tasks.pop_back();
+				}
+				task();
+				return true;
+			}
+
+		private:
+			std::mutex lock;
+			std::condition_variable wake;
+			std::deque<std::function<void()>> tasks;
+			std::vector<std::thread> workers;
+			std::atomic<unsigned> count{ 1 };
+			bool closing = false;
+
+			void work()
+			{
+				for (;;)
+				{
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> guard(lock);
+						wake.wait(guard, [this] { return closing || !tasks.empty(); });
+						if (tasks.empty()) return;
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+					task();
+				}
+			}
+
+			void stop()
+			{
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					closing = true;
+				}
+				wake.notify_all();
+				for (std::thread& t : workers) t.join();
+				workers.clear();
+				count = 1;
+			}
+		};
+
+		// fork-join scope, tasks run inline when the pool has no workers
+		class task_group
+		{
+		public:
+			task_group() = default;
+			task_group(const task_group&) = delete;
+			task_group& operator=(const task_group&) = delete;
+			~task_group() { join(); }
+
+			template<typename F>
+			void run(F f)
+			{
+				thread_pool& pool = thread_pool::instance();
+				if (pool.threads() < 2)
+				{
+					f();
+					return;
+				}
+				pending.fetch_add(1, std::memory_order_relaxed);
+				pool.push([this, f]
+				{
+					try { f(); }
+					catch (...)
+					{
+						std::lock_guard<std::mutex> guard(lock);
+						if (!error) error = std::current_exception();
+					}
+					pending.fetch_sub(1, std::memory_order_release);
+				});
+			}
+
+			void wait()
+			{
+				join();
+				if (error) std::rethrow_exception(std::exchange(error, nullptr));
+			}
+
+		private:
+			std::atomic<std::size_t> pending{ 0 };
+			std::mutex lock;
+			std::exception_ptr error;
+
+			void join()
+			{
+				while (pending.load(std::memory_order_acquire))
+					if (!thread_pool::instance().run_one()) std::this_thread::yield();
+			}
+		};
+
+		/**
+		*	Operands from this many limbs on split their independent sub-products
+		*	and conversion halves across the pool, when it has more than one thread.
+		*	The split points are the same as in the sequential code, so results are
+		*	identical for every thread count.
+		*/
+		const std::size_t parallel_threshold = 1000;
+
+		inline bool parallel_worthwhile(std::size_t limbs)
+		{
+			return limbs >= parallel_threshold && thread_pool::instance().threads() > 1;
+		}
+
+		/**
+		*	Multiplication cutoffs in limbs, measured on x86-64 with gcc -O2. The
+		*	smaller operand selects the algorithm: schoolbook below karatsuba,
+		*	Toom-3 from toom3 and NTT from ntt limbs onwards.
+		*/
+		const std::size_t karatsuba_threshold = 32;
+		const std::size_t toom3_threshold = 400;
+		const std::size_t ntt_threshold = 6000;
+
+		// r[an+bn] = a * b, r must not alias the inputs
+		inline void mul_basecase(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			r[an] = mul_1(r, a, an, b[0]);
+			for (std::size_t j = 1; j < bn; ++j)
+				r[an + j] = addmul_1(r + j, a, an, b[j]);
+		}
+
+		inline void mul(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, scratch_stack& s);
+		inline void mul(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn);
+
+		// Karatsuba step for an >= bn > (an + 1) / 2
+		inline void mul_karatsuba(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, scratch_stack& s)
+		{
+			const std::size_t m = (an + 1) / 2, a1n = an - m, b1n = bn - m;
+			scratch_frame frame(s);
+			limb_t* sa = s.take(2 * (m + 1));
+			limb_t* sb = sa + m + 1;
+			limb_t* z1 = s.take(2 * (m + 1));
+			sa[m] = add(sa, a, m, a + m, a1n);
+			sb[m] = add(sb, b, m, b + m, b1n);
+
+			if (parallel_worthwhile(bn))
+			{
+				task_group g;
+				g.run([=] { mul(r + 2 * m, a + m, a1n, b + m, b1n); });
+				g.run([=] { mul(z1, sa, m + 1, sb, m + 1); });
+				mul(r, a, m, b, m, s);
+				g.wait();
+			}
+			else
+			{
+				mul(r, a, m, b, m, s);
+				mul(r + 2 * m, a + m, a1n, b + m, b1n, s);
+				mul(z1, sa, m + 1, sb, m + 1, s);
+			}
+			sub(z1, z1, 2 * (m + 1), r, 2 * m);
+			sub(z1, z1, 2 * (m + 1), r + 2 * m, a1n + b1n);
+			add(r + m, r + m, an + bn - m, z1, normalized_size(z1, 2 * (m + 1)));
+		}
+
+		// e[k+1] = a0 + m1 * a1 + m2 * a2 for a split into k, k and a2n limbs
+		inline void toom3_evaluate(limb_t* e, const limb_t* a, std::size_t k, std::size_t a2n, limb_t m1, limb_t m2)
+		{
+			std::copy(a, a + k, e);
+			e[k] = addmul_1(e, a + k, k, m1);
+			const limb_t c = addmul_1(e, a + 2 * k, a2n, m2);
+			e[k] += add_1(e + a2n, e + a2n, k - a2n, c);
+		}
+
+		/**
+		*	Toom-3 step for an >= bn > 2 * ceil(an / 3). The operands are evaluated at
+		*	0, 1, 2, 3 and infinity; with these points every intermediate value of the
+		*	interpolation stays non-negative, so only unsigned kernels are needed.
+		*/
+		inline void mul_toom3(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, scratch_stack& s)
+		{
+			const std::size_t k = (an + 2) / 3, a2n = an - 2 * k, b2n = bn - 2 * k, e = k + 1, p = 2 * e, rn = an + bn;
+			scratch_frame frame(s);
+			limb_t* ea = s.take(3 * e);
+			limb_t* eb = s.take(3 * e);
+			limb_t* w = s.take(4 * p);
+			limb_t* w1 = w;
+			limb_t* w2 = w + p;
+			limb_t* w3 = w + 2 * p;
+			limb_t* t = w + 3 * p;
+
+			for (limb_t x = 1; x <= 3; ++x)
+			{
+				toom3_evaluate(ea + (x - 1) * e, a, k, a2n, x, x * x);
+				toom3_evaluate(eb + (x - 1) * e, b, k, b2n, x, x * x);
+			}
+			if (parallel_worthwhile(bn))
+			{
+				task_group g;
+				for (std::size_t i = 0; i < 3; ++i)
+					g.run([=] { mul(w + i * p, ea + i * e, e, eb + i * e, e); });
+				g.run([=] { mul(r + 4 * k, a + 2 * k, a2n, b + 2 * k, b2n); });
+				mul(r, a, k, b, k, s);
+				g.wait();
+			}
+			else
+			{
+				for (std::size_t i = 0; i < 3; ++i)
+					mul(w + i * p, ea + i * e, e, eb + i * e, e, s);
+				mul(r, a, k, b, k, s);
+				mul(r + 4 * k, a + 2 * k, a2n, b + 2 * k, b2n, s);
+			}
+			std::fill(r + 2 * k, r + 4 * k, limb_t(0));
+
+			// w(x) - c0 - x^4 * c4, scaled down by x
+			const limb_t* c0 = r;
+			const limb_t* c4 = r + 4 * k;
+			const std::size_t c4n = a2n + b2n;
+			for (limb_t x = 1; x <= 3; ++x)
+			{
+				limb_t* wx = w + (x - 1) * p;
+				sub(wx, wx, p, c0, 2 * k);
+				t[c4n] = mul_1(t, c4, c4n, x * x * x * x);
+				sub(wx, wx, p, t, c4n + 1);
+				divrem_1(wx, wx, p, x);
+			}
+
+			// w1 = c1 + c2 + c3, w2 = c1 + 2 c2 + 4 c3, w3 = c1 + 3 c2 + 9 c3
+			sub_n(w3, w3, w2, p);
+			sub_n(w2, w2, w1, p);
+			sub_n(w3, w3, w2, p);
+			rshift(w3, w3, p, 1);
+			submul_1(w2, w3, p, 3);
+			sub_n(w1, w1, w2, p);
+			sub_n(w1, w1, w3, p);
+
+			add(r + k, r + k, rn - k, w1, normalized_size(w1, p));
+			add(r + 2 * k, r + 2 * k, rn - 2 * k, w2, normalized_size(w2, p));
+			add(r + 3 * k, r + 3 * k, rn - 3 * k, w3, normalized_size(w3, p));
+		}
+
+		inline limb_t pow_mod(limb_t b, limb_t e, limb_t p)
+		{
+			dlimb_t result = 1, x = b;
+			for (; e; e >>= 1, x = x * x % p)
+				if (e & 1) result = result * x % p;
+			return limb_t(result);
+		}
+
+		// in-place transform of x[n] modulo the prime p, which has primitive root 3
+		template<limb_t p>
+		void ntt(limb_t* x, std::size_t n, bool inverse, limb_t* roots)
+		{
+			for (std::size_t i = 1, j = 0; i < n; ++i)
+			{
+				std::size_t bit = n >> 1;
+				for (; j & bit; bit >>= 1) j ^= bit;
+				j ^= bit;
+				if (i < j) std::swap(x[i], x[j]);
+			}
+			for (std::size_t len = 2; len <= n; len <<= 1)
+			{
+				const std::size_t half = len / 2;
+				limb_t w = pow_mod(3, limb_t((p - 1) / len), p);
+				if (inverse) w = pow_mod(w, p - 2, p);
+				roots[0] = 1;
+				for (std::size_t j = 1; j < half; ++j) roots[j] = limb_t(dlimb_t(roots[j - 1]) * w % p);
+				for (std::size_t i = 0; i < n; i += len)
+					for (std::size_t j = 0; j < half; ++j)
+					{
+						const limb_t u = x[i + j], v = limb_t(dlimb_t(x[i + j + half]) * roots[j] % p);
+						x[i + j] = u + v >= p ? u + v - p : u + v;
+						x[i + j + half] = u >= v ? u - v : u + p - v;
+					}
+			}
+			if (inverse)
+			{
+				const dlimb_t scale = pow_mod(limb_t(n % p), p - 2, p);
+				for (std::size_t i = 0; i < n; ++i) x[i] = limb_t(x[i] * scale % p);
+			}
+		}
+
+		// cyclic convolution of the 16-bit digits of a and b modulo p into fa[len], roots[len] is scratch
+		template<limb_t p>
+		void ntt_convolve(limb_t* fa, limb_t* fb, std::size_t len, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, limb_t* roots)
+		{
+			std::fill(fa, fa + len, limb_t(0));
+			std::fill(fb, fb + len, limb_t(0));
+			for (std::size_t i = 0; i < an; ++i) { fa[2 * i] = a[i] & 0xffff; fa[2 * i + 1] = a[i] >> 16; }
+			for (std::size_t i = 0; i < bn; ++i) { fb[2 * i] = b[i] & 0xffff; fb[2 * i + 1] = b[i] >> 16; }
+			if (parallel_worthwhile(std::min(an, bn)))
+			{
+				task_group g;
+				g.run([=] { ntt<p>(fb, len, false, roots + len / 2); });
+				ntt<p>(fa, len, false, roots);
+				g.wait();
+			}
+			else
+			{
+				ntt<p>(fa, len, false, roots);
+				ntt<p>(fb, len, false, roots);
+			}
+			for (std::size_t i = 0; i < len; ++i) fa[i] = limb_t(dlimb_t(fa[i]) * fb[i] % p);
+			ntt<p>(fa, len, true, roots);
+		}
+
+		/**
+		*	Two-prime NTT product over 16-bit digits. A coefficient is below
+		*	2^32 * 2^22 while the primes multiply to about 2^58, so the convolution
+		*	is exact for transforms up to ntt_max_length.
+		*/
+		const limb_t ntt_prime0 = 998244353, ntt_prime1 = 469762049;
+		const std::size_t ntt_max_length = std::size_t(1) << 23;
+
+		inline std::size_t ntt_length(std::size_t an, std::size_t bn)
+		{
+			std::size_t len = 1;
+			while (len < 2 * (an + bn)) len <<= 1;
+			return len;
+		}
+
+		inline void mul_ntt(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, scratch_stack& s)
+		{
+			const std::size_t len = ntt_length(an, bn);
+			scratch_frame frame(s);
+			limb_t* roots = s.take(len);
+			limb_t* res0 = s.take(len);
+			limb_t* res1 = s.take(len);
+			limb_t* tmp = s.take(len);
+			if (parallel_worthwhile(bn))
+			{
+				limb_t* roots1 = s.take(len);
+				limb_t* tmp1 = s.take(len);
+				task_group g;
+				g.run([=] { ntt_convolve<ntt_prime1>(res1, tmp1, len, a, an, b, bn, roots1); });
+				ntt_convolve<ntt_prime0>(res0, tmp, len, a, an, b, bn, roots);
+				g.wait();
+			}
+			else
+			{
+				ntt_convolve<ntt_prime0>(res0, tmp, len, a, an, b, bn, roots);
+				ntt_convolve<ntt_prime1>(res1, tmp, len, a, an, b, bn, roots);
+			}
+
+			// Garner reconstruction followed by carry propagation in 16-bit digits
+			const dlimb_t p0 = ntt_prime0, p1 = ntt_prime1, inv = pow_mod(ntt_prime0 % ntt_prime1, ntt_prime1 - 2, ntt_prime1);
+			dlimb_t carry = 0;
+			for (std::size_t i = 0; i < 2 * (an + bn); ++i)
+			{
+				const dlimb_t r0 = res0[i], r1 = res1[i];
+				const dlimb_t t = (r1 + p1 - r0 % p1) % p1 * inv % p1;
+				carry += r0 + t * p0;
+				if (i % 2) r[i / 2] |= limb_t(carry & 0xffff) << 16;
+				else r[i / 2] = limb_t(carry & 0xffff);
+				carry >>= 16;
+			}
+		}
+
+		// r[an+bn] = a * b, r must not alias the inputs
+		inline void mul(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn, scratch_stack& s)
+		{
+			if (an < bn)
+			{
+				std::swap(a, b);
+				std::swap(an, bn);
+			}
+			if (!bn)
+			{
+				std::fill(r, r + an, limb_t(0));
+				return;
+			}
+			if (bn < karatsuba_threshold)
+			{
+				mul_basecase(r, a, an, b, bn);
+				return;
+			}
+			if (bn >= ntt_threshold && ntt_length(an, bn) <= ntt_max_length)
+			{
+				mul_ntt(r, a, an, b, bn, s);
+				return;
+			}
+			if (bn >= toom3_threshold && bn > 2 * ((an + 2) / 3))
+			{
+				mul_toom3(r, a, an, b, bn, s);
+				return;
+			}
+			if (bn > (an + 1) / 2)
+			{
+				mul_karatsuba(r, a, an, b, bn, s);
+				return;
+			}
+
+			// unbalanced operands: multiply b by bn-sized slices of a
+			scratch_frame frame(s);
+			limb_t* tmp = s.take(2 * bn);
+			std::fill(r, r + an + bn, limb_t(0));
+			for (std::size_t off = 0; off < an; off += bn)
+			{
+				const std::size_t len = std::min(bn, an - off);
+				mul(tmp, a + off, len, b, bn, s);
+				add(r + off, r + off, an + bn - off, tmp, len + bn);
+			}
+		}
+
+		// r[an+bn] = a * b, r must not alias the inputs
+		inline void mul(limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			if (std::min(an, bn) < karatsuba_threshold)
+			{
+				if (an < bn) mul_basecase(r, b, bn, a, an);
+				else if (bn) mul_basecase(r, a, an, b, bn);
+				else std::fill(r, r + an, limb_t(0));
+				return;
+			}
+			// one scratch allocation for the whole recursion in the common case
+			std::size_t hint = 8 * (an + bn) + 64;
+			if (std::min(an, bn) >= ntt_threshold) hint += 4 * ntt_length(an, bn);
+			scratch_stack s(hint);
+			mul(r, a, an, b, bn, s);
+		}
+
+		/**
+		*	Knuth's Algorithm D. v[vn] must be normalized (top bit set) and the top
+		*	vn limbs of u[un] must be less than v. Writes un-vn quotient limbs to q
+		*	and leaves the remainder in u[0..vn).
+		*/
+		inline void divrem_basecase(limb_t* q, limb_t* u, std::size_t un, const limb_t* v, std::size_t vn)
+		{
+			const dlimb_t b = dlimb_t(1) << limb_bits;
+			const limb_t v1 = v[vn - 1], v2 = v[vn - 2];
+			for (std::size_t j = un - vn; j--; )
+			{
+				const dlimb_t num = (dlimb_t(u[j + vn]) << limb_bits) | u[j + vn - 1];
+				dlimb_t qhat = num / v1, rhat = num % v1;
+				while (qhat >= b || qhat * v2 > ((rhat << limb_bits) | u[j + vn - 2]))
+				{
+					--qhat;
+					rhat += v1;
+					if (rhat >= b) break;
+				}
+
+				const limb_t borrow = submul_1(u + j, v, vn, limb_t(qhat));
+				const limb_t top = u[j + vn];
+				u[j + vn] = top - borrow;
+				if (top < borrow)
+				{
+					--qhat;
+					u[j + vn] += add_n(u + j, u + j, v, vn);
+				}
+				q[j] = limb_t(qhat);
+			}
+		}
+
+		inline void div_2n_1n(limb_t* q, limb_t* a, const limb_t* b, std::size_t n);
+
+		/**
+		*	Burnikel-Ziegler 3n/2n step with h = n/2: divides a[3h] by b[2h] where
+		*	the top 2h limbs of a are less than b. Writes h quotient limbs to q and
+		*	leaves the remainder in a[0..2h).
+		*/
+		inline void div_3n_2n(limb_t* q, limb_t* a, const limb_t* b, std::size_t h)
+		{
+			if (cmp(a + 2 * h, h, b + h, h) < 0)
+				div_2n_1n(q, a + h, b + h, h);
+			else
+			{
+				// quotient estimate is B^h - 1, remainder estimate [a1 a2] - b1 * B^h + b1
+				std::fill(q, q + h, ~limb_t(0));
+				sub_n(a + 2 * h, a + 2 * h, b + h, h);
+				add(a + h, a + h, 2 * h, b + h, h);
+			}
+
+			scratch_buffer d(2 * h);
+			mul(d.data(), q, h, b, h);
+			limb_t borrow = sub(a, a, 3 * h, d.data(), 2 * h);
+			while (borrow)
+			{
+				sub_1(q, q, h, 1);
+				borrow -= add(a, a, 3 * h, b, 2 * h);
+			}
+		}
+
+		/**
+		*	Burnikel-Ziegler 2n/1n step: divides a[2n] by normalized b[n] where the
+		*	top n limbs of a are less than b. Writes n quotient limbs to q and
+		*	leaves the remainder in a[0..n).
+		*/
+		inline void div_2n_1n(limb_t* q, limb_t* a, const limb_t* b, std::size_t n)
+		{
+			if (n % 2 || n < burnikel_ziegler_threshold)
+			{
+				divrem_basecase(q, a, 2 * n, b, n);
+				return;
+			}
+			const std::size_t h = n / 2;
+			div_3n_2n(q + h, a + h, b, h);
+			div_3n_2n(q, a, b, h);
+		}
+
+		/**
+		*	q[an-bn+1] = a / b, r[bn] = a % b for an >= bn and b[bn-1] != 0.
+		*	Outputs must not alias the inputs.
+		*/
+		inline void divrem(limb_t* q, limb_t* r, const limb_t* a, std::size_t an, const limb_t* b, std::size_t bn)
+		{
+			if (bn == 1)
+			{
+				q[an - 1] = 0;
+				r[0] = divrem_1(q, a, an, b[0]);
+				return;
+			}
+
+			const unsigned s = leading_zeros(b[bn - 1]);
+			if (bn < burnikel_ziegler_threshold)
+			{
+				scratch_buffer u(an + 1), v(bn);
+				lshift(v.data(), b, bn, s);
+				u[an] = lshift(u.data(), a, an, s);
+				divrem_basecase(q, u.data(), an + 1, v.data(), bn);
+				rshift(r, u.data(), bn, s);
+				return;
+			}
+
+			// pad the divisor with low zero limbs so that it halves evenly down to the base case
+			std::size_t n = bn, levels = 0;
+			while (n >= burnikel_ziegler_threshold)
+			{
+				n = (n + 1) / 2;
+				++levels;
+			}
+			n <<= levels;
+			const std::size_t pad = n - bn, len = an + pad + 1, blocks = (len + n - 1) / n + 1;
+
+			scratch_buffer u(blocks * n), v(n), quot((blocks - 1) * n);
+			std::fill(u.data(), u.data() + u.size(), limb_t(0));
+			std::fill(v.data(), v.data() + pad, limb_t(0));
+			lshift(v.data() + pad, b, bn, s);
+			u[an + pad] = lshift(u.data() + pad, a, an, s);
+			for (std::size_t j = blocks - 1; j--; )
+				div_2n_1n(quot.data() + j * n, u.data() + j * n, v.data(), n);
+
+			std::copy(quot.data(), quot.data() + (an - bn + 1), q);
+			rshift(r, u.data() + pad, bn, s);
+		}
+
+		constexpr unsigned digit_value(char c)
+		{
+			if ('0' <= c && c <= '9') return unsigned(c - '0');
+			if ('a' <= c && c <= 'z') return unsigned(c - 'a' + 10);
+			if ('A' <= c && c <= 'Z') return unsigned(c - 'A' + 10);
+			return 36;
+		}
+
+		inline char digit_char(unsigned d) { return char(d < 10 ? '0' + d : 'a' + d - 10); }
+
+		// number of base digits that always fit in a single limb
+		constexpr unsigned chunk_digits(unsigned base, dlimb_t power = 1)
+		{
+			return power * base > ~limb_t(0) ? 0 : 1 + chunk_digits(base, power * base);
+		}
+
+		constexpr limb_t chunk_base(unsigned base, unsigned digits)
+		{
+			return digits ? base * chunk_base(base, digits - 1) : 1;
+		}
+
+		/**
+		*	Limbs of the integer literal c..., computed at compile time for _big.
+		*	Accepts what the built-in integer literals do: decimal, 0x hexadecimal,
+		*	0b binary and 0 octal digits with optional ' separators. Floating
+		*	literals such as 1.5_big or 1e3_big have digits out of range, so the
+		*	throw below stops them from compiling.
+		*/
+		template<char... c>
+		struct literal_value
+		{
+			// at most 4 bits per character
+			static constexpr std::size_t capacity = sizeof...(c) / 8 + 1;
+
+			limb_t limbs[capacity] = {};
+			std::size_t size = 0;
+
+			constexpr literal_value()
+			{
+				const char s[] = { c... };
+				unsigned radix = 10;
+				std::size_t i = 0;
+				if (sizeof...(c) > 1 && s[0] == '0')
+				{
+					const bool prefixed = s[1] == 'x' || s[1] == 'X' || s[1] == 'b' || s[1] == 'B';
+					radix = s[1] == 'x' || s[1] == 'X' ? 16 : prefixed ? 2 : 8;
+					i = prefixed ? 2 : 1;
+				}
+				for (; i < sizeof...(c); ++i)
+				{
+					if (s[i] == '\'') continue;
+					if (digit_value(s[i]) >= radix) throw std::invalid_argument("Only integer literals can be _big.");
+					dlimb_t carry = digit_value(s[i]);
+					for (std::size_t j = 0; j < size; ++j)
+					{
+						carry += dlimb_t(limbs[j]) * radix;
+						limbs[j] = limb_t(carry);
+						carry >>= limb_bits;
+					}
+					if (carry) limbs[size++] = limb_t(carry);
+				}
+			}
+		};
+
+		// the window of sliding window exponentiation for an exponent of the given bit length
+		constexpr unsigned power_window(std::size_t bits)
+		{
+			return bits <= 8 ? 1 : bits <= 64 ? 3 : bits <= 512 ? 4 : bits <= 4096 ? 5 : 6;
+		}
+
+		/**
+		*	Left-to-right sliding window over the bits of the exponent e[0..size),
+		*	shared by BigInt::Power and ModContext::PowMod. The caller precomputes
+		*	the odd powers for power_window; square() squares the result and
+		*	multiply(i) multiplies it by the odd power 2i+1.
+		*/
+		template<typename Square, typename Multiply>
+		void sliding_window(const limb_t* e, std::size_t size, Square square, Multiply multiply)
+		{
+			const auto bit = [e](std::size_t i) { return std::size_t(e[i / limb_bits] >> (i % limb_bits)) & 1; };
+			const std::size_t bits = size ? size * limb_bits - leading_zeros(e[size - 1]) : 0;
+			const unsigned window = power_window(bits);
+			for (std::size_t i = bits; i--; )
+			{
+				if (!bit(i))
+				{
+					square();
+					continue;
+				}
+				std::size_t j = i + 1 > window ? i + 1 - window : 0;
+				while (!bit(j)) ++j;
+				std::size_t value = 0;
+				for (std::size_t k = i + 1; k-- > j; )
+				{
+					value = (value << 1) | bit(k);
+					square();
+				}
+				multiply(value >> 1);
+				i = j;
+			}
+		}
+
+		/**
+		*	Limb storage that keeps up to two limbs inline, so values below 2^64
+		*	never touch the heap. Grows into a heap buffer like std::vector.
+		*/
+		class limb_vector
+		{
+		public:
+			static const std::size_t inline_capacity = 2;
+
+			limb_vector() { }
+			explicit limb_vector(std::size_t n, limb_t value = 0) { assign(n, value); }
+			template<typename It> limb_vector(It first, It last) { assign(first, last); }
+			limb_vector(const limb_vector& other) { assign(other.begin(), other.end()); }
+			limb_vector(limb_vector&& other) noexcept { steal(other); }
+			~limb_vector() { release(); }
+
+			limb_vector& operator=(const limb_vector& other) { if (this != &other) assign(other.begin(), other.end()); return *this; }
+			limb_vector& operator=(limb_vector&& other) noexcept { if (this != &other) { release(); steal(other); } return *this; }
+
+			inline limb_t* data() { return ptr; }
+			inline const limb_t* data() const { return ptr; }
+			inline limb_t* begin() { return ptr; }
+			inline const limb_t* begin() const { return ptr; }
+			inline limb_t* end() { return ptr + len; }
+			inline const limb_t* end() const { return ptr + len; }
+			inline std::size_t size() const { return len; }
+			inline bool empty() const { return !len; }
+			inline limb_t& operator[](std::size_t i) { return ptr[i]; }
+			inline const limb_t& operator[](std::size_t i) const { return ptr[i]; }
+			inline limb_t& back() { return ptr[len - 1]; }
+			inline const limb_t& back() const { return ptr[len - 1]; }
+			inline bool is_inline() const { return ptr == local; }
+
+			inline void reserve(std::size_t n) { if (n > cap) grow(n); }
+			inline void resize(std::size_t n, limb_t value = 0)
+			{
+				reserve(n);
+				if (n > len) std::fill(ptr + len, ptr + n, value);
+				len = n;
+			}
+			inline void assign(std::size_t n, limb_t value) { len = 0; resize(n, value); }
+			template<typename It> void assign(It first, It last)
+			{
+				const std::size_t n = std::size_t(std::distance(first, last));
+				len = 0;
+				reserve(n);
+				std::copy(first, last, ptr);
+				len = n;
+			}
+			inline void push_back(limb_t value)
+			{
+				if (len == cap) grow(2 * cap);
+				ptr[len++] = value;
+			}
+			inline void pop_back() { --len; }
+			inline void clear() { len = 0; }
+			void swap(limb_vector& other)
+			{
+				limb_vector tmp(std::move(other));
+				other = std::move(*this);
+				*this = std::move(tmp);
+			}
+
+			bool operator==(const limb_vector& rhs) const { return len == rhs.len && std::equal(begin(), end(), rhs.begin()); }
+			bool operator!=(const limb_vector& rhs) const { return !(*this == rhs); }
+
+		private:
+			limb_t local[inline_capacity];
+			limb_t* ptr = local;
+			std::size_t len = 0, cap = inline_capacity;
+
+			void grow(std::size_t n)
+			{
+				n = std::max(n, 2 * cap);
+				limb_t* p = new limb_t[n];
+				std::copy(ptr, ptr + len, p);
+				release();
+				ptr = p;
+				cap = n;
+			}
+			void release()
+			{
+				if (ptr != local) delete[] ptr;
+				ptr = local;
+				cap = inline_capacity;
+			}
+			void steal(limb_vector& other)
+			{
+				if (other.ptr == other.local)
+					std::copy(other.local, other.local + other.len, local);
+				else
+				{
+					ptr = other.ptr;
+					cap = other.cap;
+					other.ptr = other.local;
+					other.cap = inline_capacity;
+				}
+				len = other.len;
+				other.len = 0;
+			}
+		};
+
+		/**
+		*	Radix conversion cutoffs: strings and values below these sizes are
+		*	converted one limb-sized chunk of digits at a time, larger ones are
+		*	split in half around a cached power of the radix.
+		*/
+		const std::size_t parse_threshold = 1000;
+		const std::size_t format_threshold = 40;
+
+		/**
+		*	chunk_base(base)^(2^k), cached for every radix. The cache is shared by
+		*	all threads; published powers never move, and new ones are squared
+		*	outside the lock since the multiplication may itself use the pool.
+		*/
+		inline const std::vector<limb_t>& radix_power(unsigned base, std::size_t k)
+		{
+			static std::mutex lock;
+			static std::vector<std::unique_ptr<const std::vector<limb_t>>> cache[37];
+			std::vector<std::unique_ptr<const std::vector<limb_t>>>& powers = cache[base];
+			std::unique_lock<std::mutex> guard(lock);
+			if (powers.empty())
+				powers.emplace_back(new std::vector<limb_t>(1, chunk_base(base, chunk_digits(base))));
+			while (powers.size() <= k)
+			{
+				const std::vector<limb_t>* last = powers.back().get();
+				guard.unlock();
+				std::unique_ptr<std::vector<limb_t>> next(new std::vector<limb_t>(2 * last->size()));
+				mul(next->data(), last->data(), last->size(), last->data(), last->size());
+				next->resize(normalized_size(next->data(), next->size()));
+				guard.lock();
+				if (powers.back().get() == last) powers.push_back(std::move(next));
+			}
+			return *powers[k];
+		}
+
+		// r = hi * power + lo for lo < power, r must not alias hi; lo may be taken over
+		template<typename Power>
+		void shift_add(limb_vector& r, const limb_vector& hi, const Power& power, limb_vector& lo)
+		{
+			if (hi.empty())
+			{
+				r.swap(lo);
+				return;
+			}
+			r.assign(hi.size() + power.size() + 1, 0);
+			mul(r.data(), hi.data(), hi.size(), power.data(), power.size());
+			add(r.data(), r.data(), r.size(), lo.data(), lo.size());
+			r.resize(normalized_size(r.data(), r.size()));
+		}
+
+		// appends the value of the digits s[len] to the empty r
+		inline void parse_basecase(limb_vector& r, const char* s, std::size_t len, unsigned base)
+		{
+			const unsigned chunk = chunk_digits(base);
+			r.reserve(len / chunk + 1);
+			limb_t acc = 0, scale = 1;
+			unsigned digits = 0;
+			for (std::size_t i = 0; i < len; ++i)
+			{
+				const unsigned d = digit_value(s[i]);
+				if (d >= base)
+					throw std::invalid_argument("Initiallization string contains illegal characters.");
+				acc = acc * base + d;
+				scale *= base;
+				if (++digits == chunk || i + 1 == len)
+				{
+					limb_t c = mul_1(r.data(), r.data(), r.size(), scale);
+					c += add_1(r.data(), r.data(), r.size(), acc);
+					if (c) r.push_back(c);
+					acc = 0;
+					scale = 1;
+					digits = 0;
+				}
+			}
+			r.resize(normalized_size(r.data(), r.size()));
+		}
+
+		// r = value of the digits s[len], split as high * base^low + low
+		inline void parse(limb_vector& r, const char* s, std::size_t len, unsigned base)
+		{
+			if (len < parse_threshold)
+			{
+				parse_basecase(r, s, len, base);
+				return;
+			}
+			std::size_t k = 0;
+			while ((std::size_t(chunk_digits(base)) << (k + 1)) < len) ++k;
+			const std::size_t low = std::size_t(chunk_digits(base)) << k;
+
+			limb_vector hi, lo;
+			if (parallel_worthwhile(len / chunk_digits(base)))
+			{
+				task_group g;
+				g.run([&] { parse(lo, s + len - low, low, base); });
+				parse(hi, s, len - low, base);
+				g.wait();
+			}
+			else
+			{
+				parse(hi, s, len - low, base);
+				parse(lo, s + len - low, low, base);
+			}
+			shift_add(r, hi, radix_power(base, k), lo);
+		}
+
+		/**
+		*	Parser for digits that arrive in order, most significant first, in
+		*	blocks of block_size() digits and a final shorter one. Full blocks are
+		*	merged like a binary counter: two values of 2^i blocks each combine as
+		*	hi * base^(digits of lo) + lo, so the products are as balanced as in
+		*	parse and only the value read so far is held, never the digits.
+		*/
+		class stream_parser
+		{
+		public:
+			explicit stream_parser(unsigned _base) : base(_base) {}
+
+			inline std::size_t block_size() const { return std::size_t(chunk_digits(base)) << block_level; }
+
+			void push(const char* s, std::size_t len)
+			{
+				part p;
+				parse(p.value, s, len, base);
+				for (; !parts.empty() && parts.back().level == p.level; ++p.level)
+				{
+					limb_vector merged;
+					shift_add(merged, parts.back().value, radix_power(base, block_level + p.level), p.value);
+					p.value.swap(merged);
+					parts.pop_back();
+				}
+				parts.push_back(std::move(p));
+			}
+
+			/**
+			*	r = value of all full blocks followed by the tail digits s[len].
+			*	The parts are folded in from the least significant one, so each
+			*	is multiplied by a power of about its own size.
+			*/
+			void finish(limb_vector& r, const char* s, std::size_t len)
+			{
+				// power = base^len from the cached powers and one chunk_base(base, len % chunk)
+				const unsigned chunk = chunk_digits(base);
+				limb_vector power(1, chunk_base(base, unsigned(len % chunk)));
+				for (std::size_t k = 0, q = len / chunk; q; ++k, q >>= 1)
+					if (q & 1) scale(power, radix_power(base, k));
+				r.clear();
+				parse(r, s, len, base);
+
+				while (!parts.empty())
+				{
+					limb_vector next;
+					shift_add(next, parts.back().value, power, r);
+					r.swap(next);
+					if (parts.size() > 1) scale(power, radix_power(base, block_level + parts.back().level));
+					parts.pop_back();
+				}
+			}
+
+		private:
+			struct part
+			{
+				limb_vector value;
+				std::size_t level = 0;
+			};
+
+			// blocks of chunk_digits(base) << 12 digits, 36864 for base 10
+			static const std::size_t block_level = 12;
+
+			static void scale(limb_vector& x, const std::vector<limb_t>& factor)
+			{
+				limb_vector product(x.size() + factor.size());
+				mul(product.data(), x.data(), x.size(), factor.data(), factor.size());
+				product.resize(normalized_size(product.data(), product.size()));
+				x.swap(product);
+			}
+
+			unsigned base;
+			std::vector<part> parts;
+		};
+
+		// appends the digits of a[n] to out, left-padded with zeros to width
+		inline void format_basecase(string& out, const limb_t* a, std::size_t n, std::size_t width, unsigned base)
+		{
+			const unsigned chunk = chunk_digits(base);
+			const limb_t divisor = chunk_base(base, chunk);
+			scratch_buffer tmp(n);
+			std::copy(a, a + n, tmp.data());
+			const std::size_t start = out.size();
+			n = normalized_size(tmp.data(), n);
+			while (n)
+			{
+				limb_t r = divrem_1(tmp.data(), tmp.data(), n, divisor);
+				n = normalized_size(tmp.data(), n);
+				for (unsigned k = 0; k < chunk && (n || r); ++k, r /= base)
+					out += digit_char(r % base);
+			}
+			if (out.size() - start < width) out.append(width - (out.size() - start), '0');
+			std::reverse(out.begin() + start, out.end());
+		}
+
+		/**
+		*	Destination of format that hands the digits on to a stream in blocks,
+		*	so printing holds one block of text instead of the whole string.
+		*/
+		class stream_sink
+		{
+		public:
+			explicit stream_sink(std::ostream& _os) : os(_os) { buffer.reserve(block_size); }
+
+			void append(const char* s, std::size_t n)
+			{
+				buffer.append(s, n);
+				if (buffer.size() >= block_size) flush();
+			}
+
+			void flush()
+			{
+				os.write(buffer.data(), std::streamsize(buffer.size()));
+				buffer.clear();
+			}
+
+		private:
+			static const std::size_t block_size = std::size_t(1) << 16;
+
+			std::ostream& os;
+			string buffer;
+		};
+
+		// appends the digits of a[n] to out, a string or stream_sink, left-padded with zeros to width
+		template<typename Sink>
+		void format(Sink& out, const limb_t* a, std::size_t n, std::size_t width, unsigned base)
+		{
+			n = normalized_size(a, n);
+			if (n < format_threshold)
+			{
+				if constexpr (std::is_same<Sink, string>::value)
+					format_basecase(out, a, n, width, base);
+				else
+				{
+					string digits;
+					format_basecase(digits, a, n, width, base);
+					out.append(digits.data(), digits.size());
+				}
+				return;
+			}
+			std::size_t k = 0;
+			while (radix_power(base, k + 1).size() <= (n + 1) / 2) ++k;
+			const std::vector<limb_t>& power = radix_power(base, k);
+			const std::size_t low = std::size_t(chunk_digits(base)) << k;
+
+			scratch_buffer q(n - power.size() + 1), r(power.size());
+			divrem(q.data(), r.data(), a, n, power.data(), power.size());
+			if (parallel_worthwhile(n))
+			{
+				string digits;
+				task_group g;
+				g.run([&] { format(digits, r.data(), r.size(), low, base); });
+				format(out, q.data(), q.size(), width > low ? width - low : 0, base);
+				g.wait();
+				out.append(digits.data(), digits.size());
+			}
+			else
+			{
+				format(out, q.data(), q.size(), width > low ? width - low : 0, base);
+				format(out, r.data(), r.size(), low, base);
+			}
+		}
+
+		/**
+		*	Lehmer matrix from the leading 62 bits ah >= bh of two numbers: Euclid
+		*	runs on them while the remainder stays above 2^31, which keeps every
+		*	entry of m = [m0 m1; m2 m3] within 31 bits, and stops early where
+		*	Jebelean's condition says the quotient may differ for the full numbers.
+		*	Returns false if not a single step was taken.
+		*/
+		inline bool lehmer_matrix(std::uint64_t ah, std::uint64_t bh, std::int64_t m[4])
+		{
+			m[0] = 1; m[1] = 0; m[2] = 0; m[3] = 1;
+			auto magnitude = [](std::int64_t x) { return std::uint64_t(x < 0 ? -x : x); };
+			bool progress = false;
+			while (bh >= (std::uint64_t(1) << 31))
+			{
+				const std::uint64_t q = ah / bh, r = ah - q * bh;
+				const std::int64_t t0 = m[0] - std::int64_t(q) * m[2], t1 = m[1] - std::int64_t(q) * m[3];
+				if (r < std::max(magnitude(t0), magnitude(t1)) || bh - r < std::max(magnitude(t0 - m[2]), magnitude(t1 - m[3])))
+					break;
+				ah = bh;
+				bh = r;
+				m[0] = m[2]; m[1] = m[3];
+				m[2] = t0; m[3] = t1;
+				progress = true;
+			}
+			return progress;
+		}
+
+		// operands from this many limbs on take the subquadratic half-gcd path, measured on x86-64 with gcc -O2
+		const std::size_t hgcd_threshold = 1000;
+
+		inline std::uint64_t isqrt_word(std::uint64_t x)
+		{
+			std::uint64_t r = std::uint64_t(std::sqrt(double(x)));
+			while (r && r > x / r) --r;
+			while (r + 1 <= x / (r + 1)) ++r;
+			return r;
+		}
+
+		/**
+		*	Binary record of a value: 'G', 'B', the format version and a flags byte
+		*	(bit 0: negative), the limb count as 64-bit integer, then the limbs,
+		*	least significant first. All fields are little-endian.
+		*/
+		const unsigned char binary_version = 1;
+		const std::size_t binary_header_size = 12;
+
+		inline bool little_endian_host()
+		{
+			const std::uint32_t probe = 1;
+			unsigned char first;
+			std::memcpy(&first, &probe, 1);
+			return first == 1;
+		}
+
+		inline void store_le(unsigned char* p, std::uint64_t value, unsigned bytes)
+		{
+			for (unsigned i = 0; i < bytes; ++i) p[i] = (unsigned char)(value >> (8 * i));
+		}
+
+		inline std::uint64_t load_le(const unsigned char* p, unsigned bytes)
+		{
+			std::uint64_t value = 0;
+			for (unsigned i = bytes; i--; ) value = (value << 8) | p[i];
+			return value;
+		}
+
+	}
+
+	class BigIntArray;
+	template<unsigned base> class BigInt;
+	template<std::size_t bits, unsigned base> class FixedBigInt;
+
+	namespace literals {
+		template<char... c> BigInt<10> operator""_big();
+	}
+
+	/**
+	*	While a BigIntArena is alive, the temporary buffers BigInt operations on
+	*	the same thread use internally are carved from its chunks instead of the
+	*	heap, and released all at once when it is destroyed or Reset. Values
+	*	themselves are still heap allocated, so results safely outlive the scope.
+	*	Scopes nest; the innermost one is used.
+	*/
+	class BigIntArena
+	{
+	public:
+		explicit BigIntArena(std::size_t chunkBytes = std::size_t(1) << 20) : pool(chunkBytes / sizeof(detail::limb_t)), previous(detail::current_arena())
+		{
+			detail::current_arena() = &pool;
+		}
+		~BigIntArena() { detail::current_arena() = previous; }
+		BigIntArena(const BigIntArena&) = delete;
+		BigIntArena& operator=(const BigIntArena&) = delete;
+
+		// must not be called while a BigInt operation on this thread is in progress
+		inline void Reset() { pool.reset(); }
+
+	private:
+		detail::arena pool;
+		detail::arena* previous;
+	};
+
+	/**
+	*	Sets how many threads large multiplications, divisions and radix
+	*	conversions may use, 0 meaning one per hardware thread; the default is 1.
+	*	Results are the same for every setting. Must not be called while BigInt
+	*	operations are running on other threads.
+	*/
+	inline void SetBigIntThreads(unsigned threads) { detail::thread_pool::instance().set_threads(threads); }
+	inline unsigned BigIntThreads() { return detail::thread_pool::instance().threads(); }
+
+	/**
+	*	Arbitrary precision signed integer.
+	*
+	*	The magnitude is stored as binary limbs, base is only the radix used
+	*	when parsing from and printing to strings (2 to 36).
+	*/
+	template<unsigned base>
 	class BigInt
 	{
+		static_assert(base >= 2 && base <= 36, "BigInt base must be in range [2, 36].");
+		template<unsigned> friend class BigInt;
+		template<unsigned> friend class ModContext;
+		template<std::size_t, unsigned> friend class FixedBigInt;
+		friend class BigIntArray;
+		template<char... c> friend BigInt<10> literals::operator""_big();
+		typedef detail::limb_t limb_t;
+
 	public:
 		const static BigInt Zero;
 		const static BigInt One;
 
-		BigInt() : str("0") { }
+		BigInt() { }
 		BigInt(const string& _str);
 		BigInt(const char* _str) : BigInt(string(_str)) { }
-		BigInt(const BigInt& _other) : str(_other.str), sign(_other.sign) { }
-		template<unsigned rBase> BigInt(const BigInt<rBase>& rhs) { swap(*this, rhs.ToBase<base>()); }
-		template<typename T> BigInt(T _num) : BigInt(std::to_string(_num)) { static_assert(is_integral<T>::value, "Cannot construct BigInt from provided type."); }
+		BigInt(const BigInt& _other) : mag(_other.mag), sign(_other.sign) { }
+		BigInt(BigInt&& _other) noexcept : mag(std::move(_other.mag)), sign(_other.sign) { _other.sign = true; }
+		template<unsigned rBase> BigInt(const BigInt<rBase>& rhs) : mag(rhs.mag), sign(rhs.sign) { }
+		template<typename T> BigInt(T _num)
+		{
+			static_assert(std::is_integral<T>::value, "Cannot construct BigInt from provided type.");
+			unsigned long long num = static_cast<unsigned long long>(_num);
+			if (_num < T(0))
+			{
+				num = 0ull - num;
+				sign = false;
+			}
+			for (; num; num >>= detail::limb_bits)
+				mag.push_back(limb_t(num));
+		}
 		virtual ~BigInt() { }
 
-		BigInt& operator=(BigInt rhs) { swap(str, rhs.str); return *this; }
+		BigInt& operator=(const BigInt& rhs) { mag = rhs.mag; sign = rhs.sign; return *this; }
+		BigInt& operator=(BigInt&& rhs) noexcept { if (this != &rhs) { mag = std::move(rhs.mag); sign = rhs.sign; rhs.sign = true; } return *this; }
 		template<unsigned rBase> inline BigInt& operator=(const BigInt<rBase>& rhs) { return operator=(BigInt(rhs)); }
 
-		bool operator==(const BigInt& rhs) const { return (str == rhs.str) && (sign == rhs.sign || str == "0"); }
-		bool operator<(const BigInt& rhs) const 
-		{ 
+		bool operator==(const BigInt& rhs) const { return sign == rhs.sign && mag == rhs.mag; }
+		bool operator<(const BigInt& rhs) const
+		{
 			if (sign != rhs.sign) return !sign;
-			if (str.length() != rhs.str.length()) return sign ? str.length() < rhs.str.length() : !(str.length() < rhs.str.length()); 
-			auto i = str.begin();
-			auto j = rhs.str.begin();
-			for (; i != str.end(); ++i, ++j)
-				if (*i - *j) return sign ? (*i - *j) < 0 : !((*i - *j) < 0);
-			return false; 
+			return sign ? CompareMagnitude(rhs) < 0 : CompareMagnitude(rhs) > 0;
 		}
 		inline bool operator!=(const BigInt& rhs) const { return !(*this == rhs); }
 		inline bool operator>(const BigInt& rhs) const { return rhs < *this; }
-		inline bool operator<=(const BigInt& rhs) const { return !(rhs > *this); }
+		inline bool operator<=(const BigInt& rhs) const { return !(rhs < *this); }
 		inline bool operator>=(const BigInt& rhs) const { return !(*this < rhs); }
 
-		BigInt& operator+=(const BigInt& rhs);
-		BigInt& operator-=(const BigInt& rhs);
+		BigInt& operator+=(const BigInt& rhs) { return AddSigned(rhs.mag.data(), rhs.mag.size(), rhs.sign); }
+		BigInt& operator-=(const BigInt& rhs) { return AddSigned(rhs.mag.data(), rhs.mag.size(), !rhs.sign); }
 		BigInt& operator*=(const BigInt& rhs);
 		BigInt& operator/=(const BigInt& rhs);
 		BigInt& operator%=(const BigInt& rhs);
@@ -53,254 +1657,762 @@ namespace gasper {
 		template<unsigned rBase> inline BigInt& operator%=(const BigInt<rBase>& rhs) { return operator%=(BigInt(rhs)); }
 		template<unsigned rBase> inline BigInt& operator^=(const BigInt<rBase>& rhs) { return operator^=(BigInt(rhs)); }
 
-		inline BigInt& operator++() { return operator+=(One); }
-		inline BigInt operator++(int) { return operator+=(One); }
-		inline BigInt& operator--() { return operator-=(One); }
-		inline BigInt operator--(int) { return operator-=(One); }
-		inline BigInt operator-() { return 0 - *this; }
+		inline BigInt& operator++() { return sign ? IncrementMagnitude() : DecrementMagnitude(); }
+		inline BigInt operator++(int) { BigInt tmp(*this); operator++(); return tmp; }
+		inline BigInt& operator--()
+		{
+			if (sign && !mag.empty()) return DecrementMagnitude();
+			sign = false;
+			return IncrementMagnitude();
+		}
+		inline BigInt operator--(int) { BigInt tmp(*this); operator--(); return tmp; }
+		inline BigInt operator-() const & { BigInt tmp(*this); if (!tmp.mag.empty()) tmp.sign = !sign; return tmp; }
+		inline BigInt operator-() && { if (!mag.empty()) sign = !sign; return std::move(*this); }
+
+		template<unsigned b> friend std::ostream& operator<<(std::ostream& os, const BigInt<b>& obj);
+		template<unsigned b> friend std::istream& operator>>(std::istream& is, BigInt<b>& obj);
+		template<unsigned b> friend BigInt<b>& AddMul(BigInt<b>& acc, const BigInt<b>& lhs, const BigInt<b>& rhs);
+		template<unsigned b> friend BigInt<b>& SubMul(BigInt<b>& acc, const BigInt<b>& lhs, const BigInt<b>& rhs);
 
-		template<typename T> inline BigInt& operator+=(T rhs) { static_assert(is_integral<T>::value, "Cannot add with nonintegral types."); return operator+=(BigInt<10>(rhs)); }
-		template<typename T> inline BigInt& operator-=(T rhs) { static_assert(is_integral<T>::value, "Cannot subtract with nonintegral types."); return operator-=(BigInt<10>(rhs)); }
-		template<typename T> inline BigInt& operator*=(T rhs) { static_assert(is_integral<T>::value, "Cannot multiply with nonintegral type."); return operator*=(BigInt<10>(rhs)); }
-		template<typename T> inline BigInt& operator/=(T rhs) { static_assert(is_integral<T>::value, "Cannot divide by nonintegral type."); return operator/=(BigInt<10>(rhs)); }
-		template<typename T> inline BigInt& operator%=(T rhs) { static_assert(is_integral<T>::value, "Cannot divide by modulus of nonintegral type."); return operator%=(BigInt<10>(rhs)); }
-		template<typename T> inline BigInt& operator^=(T rhs) { static_assert(is_integral<T>::value, "Cannot get to power of nonintegral type."); return operator^=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator+=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot add with nonintegral types."); return operator+=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator-=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot subtract with nonintegral types."); return operator-=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator*=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot multiply with nonintegral type."); return operator*=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator/=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot divide by nonintegral type."); return operator/=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator%=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot divide by modulus of nonintegral type."); return operator%=(BigInt<10>(rhs)); }
+		template<typename T> inline BigInt& operator^=(T rhs) { static_assert(std::is_integral<T>::value, "Cannot get to power of nonintegral type."); return operator^=(BigInt<10>(rhs)); }
 
-		inline string ToString() { return (!sign ? "-" : "") + str; }
-		inline explicit operator string() { return (!sign ? "-" : "") + str; }
+		string ToString() const;
+		inline explicit operator string() const { return ToString(); }
 
-		inline unsigned Base() { return base; }
-		inline string BaseAsString() { return std::to_string(base); }
-		template<unsigned toBase> inline BigInt<toBase> ToBase() const { return BigInt<toBase>((!sign ? "-" : "") + str); }
+		inline unsigned Base() const { return base; }
+		inline string BaseAsString() const { return std::to_string(base); }
+		template<unsigned toBase> inline BigInt<toBase> ToBase() const { return BigInt<toBase>(*this); }
 
-		inline BigInt Abs() const { return BigInt(str); }
-		inline bool IsNegative() { return !sign || str == "0"; }
-		inline bool IsPositive() { return sign || str == "0"; }
+		inline void DivMod(const BigInt& rhs, BigInt& quotient, BigInt& remainder) const { DivMod(rhs, &quotient, &remainder); }
+		static BigInt PowMod(const BigInt& powerBase, const BigInt& exponent, const BigInt& modulus);
+
+		// greatest common divisor, never negative
+		static BigInt Gcd(const BigInt& lhs, const BigInt& rhs);
+		// returns g = Gcd(lhs, rhs) = lhs * x + rhs * y with 0 <= x < |rhs| / g for rhs != 0
+		static BigInt ExtGcd(const BigInt& lhs, const BigInt& rhs, BigInt& x, BigInt& y);
+		// x in [0, |modulus|) with value * x = 1 (mod modulus)
+		static BigInt ModInverse(const BigInt& value, const BigInt& modulus);
+		// floor of the square root and of the k-th root, odd roots of negative values round toward zero
+		static BigInt ISqrt(const BigInt& value);
+		static BigInt IRoot(const BigInt& value, unsigned k);
+
+		// versioned binary limb format, see detail::binary_version
+		void WriteBinary(std::ostream& os) const;
+		static BigInt ReadBinary(std::istream& is);
+
+		inline BigInt Abs() const { BigInt tmp(*this); tmp.sign = true; return tmp; }
+		inline bool IsNegative() const { return !sign || mag.empty(); }
+		inline bool IsPositive() const { return sign; }
 
 	private:
-		string str;
+		detail::limb_vector mag;
 		bool sign = true;
+
+		inline void Trim()
+		{
+			mag.resize(detail::normalized_size(mag.data(), mag.size()));
+			if (mag.empty()) sign = true;
+		}
+		inline int CompareMagnitude(const BigInt& rhs) const { return detail::cmp(mag.data(), mag.size(), rhs.mag.data(), rhs.mag.size()); }
+		BigInt& AddSigned(const limb_t* rhs, std::size_t rn, bool rhsSign);
+		BigInt& MulAccumulate(const BigInt& lhs, const BigInt& rhs, bool subtract);
+
+		// values below 2^64 take native paths without touching the limb kernels
+		inline bool FitsWord() const { return mag.size() <= 2; }
+		inline std::uint64_t Word() const
+		{
+			return mag.empty() ? 0 : mag.size() == 1 ? mag[0] : (std::uint64_t(mag[1]) << detail::limb_bits) | mag[0];
+		}
+		inline void SetWord(std::uint64_t value, bool valueSign)
+		{
+			mag.resize(value >> detail::limb_bits ? 2 : value ? 1 : 0);
+			if (value) mag[0] = limb_t(value);
+			if (value >> detail::limb_bits) mag[1] = limb_t(value >> detail::limb_bits);
+			sign = valueSign || !value;
+		}
+		inline BigInt& IncrementMagnitude()
+		{
+			if (detail::add_1(mag.data(), mag.data(), mag.size(), 1)) mag.push_back(1);
+			return *this;
+		}
+		inline BigInt& DecrementMagnitude()
+		{
+			detail::sub_1(mag.data(), mag.data(), mag.size(), 1);
+			Trim();
+			return *this;
+		}
+		void DivMod(const BigInt& rhs, BigInt* quotient, BigInt* remainder) const;
+		template<typename Reduce> static BigInt Power(const BigInt& powerBase, const BigInt& exponent, Reduce reduce);
+
+		BigInt ShiftLeft(std::size_t bits) const;
+		BigInt ShiftRight(std::size_t bits) const;
+		std::uint64_t LeadingBits(std::size_t shift) const;
+
+		// 2x2 matrices [m0 m1; m2 m3] acting on column vectors, used by the gcd
+		static void ApplyMatrix(BigInt m[4], BigInt& x, BigInt& y, bool normalize);
+		static void MultiplyMatrix(BigInt m[4], const BigInt l[4]);
+		static bool LehmerStep(BigInt& x, BigInt& y, BigInt m[4]);
+		static void DivisionStep(BigInt& x, BigInt& y, BigInt m[4]);
+		static void HalfGcd(const BigInt& a, const BigInt& b, BigInt m[4]);
+		static BigInt GcdMagnitude(BigInt a, BigInt b, BigInt* cofactor);
+
+		inline std::size_t BitLength() const { return mag.empty() ? 0 : mag.size() * detail::limb_bits - detail::leading_zeros(mag.back()); }
+		inline bool TestBit(std::size_t i) const { return i / detail::limb_bits < mag.size() && (mag[i / detail::limb_bits] >> (i % detail::limb_bits)) & 1; }
 	};
 
-	template<unsigned base> const BigInt<base> BigInt<base>::Zero = BigInt<base>("0");
-	template<unsigned base> const BigInt<base> BigInt<base>::One = BigInt<base>("1");
-	
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator+(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs += rhs; }
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator-(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs -= rhs; }
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator*(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs *= rhs; }
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator/(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs /= rhs; }
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator%(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs %= rhs; }
-	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator^(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { return lhs ^= rhs; }
-
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator+(BigInt<lBase> lhs, T rhs) { return lhs += rhs; }
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator-(BigInt<lBase> lhs, T rhs) { return lhs -= rhs; }
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator*(BigInt<lBase> lhs, T rhs) { return lhs *= rhs; }
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator/(BigInt<lBase> lhs, T rhs) { return lhs /= rhs; }
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator%(BigInt<lBase> lhs, T rhs) { return lhs %= rhs; }
-	template<unsigned lBase, typename T> inline BigInt<lBase> operator^(BigInt<lBase> lhs, T rhs) { return lhs ^= rhs; }
+	template<unsigned base> const BigInt<base> BigInt<base>::Zero = BigInt<base>(0);
+	template<unsigned base> const BigInt<base> BigInt<base>::One = BigInt<base>(1);
+
+	namespace literals {
+
+		// 123456789012345678901234567890_big, the digits are converted to limbs at compile time
+		template<char... c>
+		BigInt<10> operator""_big()
+		{
+			constexpr detail::literal_value<c...> value;
+			BigInt<10> result;
+			result.mag.assign(value.limbs, value.limbs + value.size);
+			return result;
+		}
+
+	}
+
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator+(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs += rhs; return lhs; }
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator-(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs -= rhs; return lhs; }
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator*(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs *= rhs; return lhs; }
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator/(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs /= rhs; return lhs; }
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator%(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs %= rhs; return lhs; }
+	template<unsigned lBase, unsigned rBase> inline BigInt<lBase> operator^(BigInt<lBase> lhs, const BigInt<rBase>& rhs) { lhs ^= rhs; return lhs; }
+
+	// a temporary right operand donates its buffer to the result
+	template<unsigned base> inline BigInt<base> operator+(const BigInt<base>& lhs, BigInt<base>&& rhs) { rhs += lhs; return std::move(rhs); }
+	template<unsigned base> inline BigInt<base> operator-(const BigInt<base>& lhs, BigInt<base>&& rhs) { rhs -= lhs; return -std::move(rhs); }
+	template<unsigned base> inline BigInt<base> operator*(const BigInt<base>& lhs, BigInt<base>&& rhs) { rhs *= lhs; return std::move(rhs); }
+
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator+(BigInt<lBase> lhs, T rhs) { lhs += rhs; return lhs; }
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator-(BigInt<lBase> lhs, T rhs) { lhs -= rhs; return lhs; }
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator*(BigInt<lBase> lhs, T rhs) { lhs *= rhs; return lhs; }
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator/(BigInt<lBase> lhs, T rhs) { lhs /= rhs; return lhs; }
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator%(BigInt<lBase> lhs, T rhs) { lhs %= rhs; return lhs; }
+	template<unsigned lBase, typename T> inline BigInt<lBase> operator^(BigInt<lBase> lhs, T rhs) { lhs ^= rhs; return lhs; }
 
 	template<unsigned lBase, typename T> inline bool operator==(const BigInt<lBase>& lhs, const T& rhs) { return lhs == BigInt<lBase>(rhs); }
 	template<unsigned lBase, typename T> inline bool operator!=(const BigInt<lBase>& lhs, const T& rhs) { return !(lhs == BigInt<lBase>(rhs)); }
 	template<unsigned lBase, typename T> inline bool operator< (const BigInt<lBase>& lhs, const T& rhs) { return lhs < BigInt<lBase>(rhs); }
 	template<unsigned lBase, typename T> inline bool operator> (const BigInt<lBase>& lhs, const T& rhs) { return BigInt<lBase>(rhs) < lhs; }
-	template<unsigned lBase, typename T> inline bool operator<=(const BigInt<lBase>& lhs, const T& rhs) { return !(BigInt<lBase>(rhs) > lhs); }
+	template<unsigned lBase, typename T> inline bool operator<=(const BigInt<lBase>& lhs, const T& rhs) { return !(BigInt<lBase>(rhs) < lhs); }
 	template<unsigned lBase, typename T> inline bool operator>=(const BigInt<lBase>& lhs, const T& rhs) { return !(lhs < BigInt<lBase>(rhs)); }
-	
+
 	template<unsigned rBase, typename T> inline bool operator==(const T& lhs, const BigInt<rBase>& rhs) { return BigInt<rBase>(lhs) == rhs; }
 	template<unsigned rBase, typename T> inline bool operator!=(const T& lhs, const BigInt<rBase>& rhs) { return !(BigInt<rBase>(lhs) == rhs); }
 	template<unsigned rBase, typename T> inline bool operator< (const T& lhs, const BigInt<rBase>& rhs) { return BigInt<rBase>(lhs) < rhs; }
 	template<unsigned rBase, typename T> inline bool operator> (const T& lhs, const BigInt<rBase>& rhs) { return rhs < BigInt<rBase>(lhs); }
-	template<unsigned rBase, typename T> inline bool operator<=(const T& lhs, const BigInt<rBase>& rhs) { return !(rhs > BigInt<rBase>(lhs)); }
+	template<unsigned rBase, typename T> inline bool operator<=(const T& lhs, const BigInt<rBase>& rhs) { return !(rhs < BigInt<rBase>(lhs)); }
 	template<unsigned rBase, typename T> inline bool operator>=(const T& lhs, const BigInt<rBase>& rhs) { return !(BigInt<rBase>(lhs) < rhs); }
-	
+
+	/**
+	*	Large values are formatted straight into the stream in blocks, without
+	*	building the decimal string first; padded output still goes through
+	*	ToString since the width is only known once all digits are there.
+	*/
 	template<unsigned base>
-	std::ostream& operator<<(std::ostream& os, BigInt<base>& obj)
+	std::ostream& operator<<(std::ostream& os, const BigInt<base>& obj)
 	{
-		os << obj.ToString();
+		if (os.width() || obj.mag.size() < detail::format_threshold)
+			return os << obj.ToString();
+		const std::ostream::sentry guard(os);
+		if (!guard) return os;
+		detail::stream_sink sink(os);
+		if (!obj.sign) sink.append("-", 1);
+		detail::format(sink, obj.mag.data(), obj.mag.size(), 0, base);
+		sink.flush();
 		return os;
 	}
-	
+
+	/**
+	*	Reads an optional sign and the digits up to the next whitespace. The
+	*	digits are converted in blocks while they are read, so the token is
+	*	never held as a whole. A token with an illegal character sets failbit,
+	*	leaves obj unchanged and stops at that character.
+	*/
 	template<unsigned base>
 	std::istream& operator>>(std::istream& is, BigInt<base>& obj)
 	{
-		string tmp;
-		is >> tmp;
-		obj(BigInt<10>(tmp));
+		const std::istream::sentry guard(is);
+		if (!guard) return is;
+
+		std::streambuf* in = is.rdbuf();
+		bool negative = false;
+		int c = in->sgetc();
+		if (c == '+' || c == '-')
+		{
+			negative = c == '-';
+			c = in->snextc();
+		}
+
+		detail::stream_parser parser(base);
+		string block;
+		block.reserve(parser.block_size());
+		bool empty = true;
+		for (; c != std::char_traits<char>::eof() && detail::digit_value(char(c)) < base; c = in->snextc())
+		{
+			block += char(c);
+			empty = false;
+			if (block.size() == parser.block_size())
+			{
+				parser.push(block.data(), block.size());
+				block.clear();
+			}
+		}
+		if (c == std::char_traits<char>::eof())
+			is.setstate(std::ios::eofbit);
+		else if (!std::isspace(char(c), is.getloc()))
+			empty = true;
+		if (empty)
+		{
+			is.setstate(std::ios::failbit);
+			return is;
+		}
+
+		BigInt<base> result;
+		parser.finish(result.mag, block.data(), block.size());
+		result.sign = !negative;
+		result.Trim();
+		obj = std::move(result);
 		return is;
 	}
 
 	template<unsigned base>
-	BigInt<base>::BigInt(const string& _str)
+	void BigInt<base>::WriteBinary(std::ostream& os) const
 	{
-		if (_str.empty())
+		unsigned char header[detail::binary_header_size] = { 'G', 'B', detail::binary_version, (unsigned char)(sign ? 0 : 1) };
+		detail::store_le(header + 4, mag.size(), 8);
+		os.write(reinterpret_cast<const char*>(header), sizeof header);
+		if (detail::little_endian_host())
 		{
-			str = "0";
+			os.write(reinterpret_cast<const char*>(mag.data()), std::streamsize(mag.size() * sizeof(limb_t)));
 			return;
 		}
+		unsigned char bytes[sizeof(limb_t)];
+		for (limb_t x : mag)
+		{
+			detail::store_le(bytes, x, sizeof bytes);
+			os.write(reinterpret_cast<const char*>(bytes), sizeof bytes);
+		}
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ReadBinary(std::istream& is)
+	{
+		unsigned char header[detail::binary_header_size];
+		if (!is.read(reinterpret_cast<char*>(header), sizeof header))
+			throw std::invalid_argument("Truncated binary BigInt record.");
+		if (header[0] != 'G' || header[1] != 'B' || header[2] != detail::binary_version || header[3] > 1)
+			throw std::invalid_argument("Unsupported binary BigInt record.");
+
+		// read in bounded steps so a corrupt length fails at the end of the stream instead of allocating
+		const std::uint64_t n = detail::load_le(header + 4, 8);
+		BigInt result;
+		for (std::uint64_t done = 0; done < n; )
+		{
+			const std::size_t step = std::size_t(std::min<std::uint64_t>(n - done, std::uint64_t(1) << 16));
+			result.mag.resize(std::size_t(done) + step);
+			char* dst = reinterpret_cast<char*>(result.mag.data() + done);
+			if (!is.read(dst, std::streamsize(step * sizeof(limb_t))))
+				throw std::invalid_argument("Truncated binary BigInt record.");
+			if (!detail::little_endian_host())
+				for (std::size_t i = 0; i < step; ++i)
+					result.mag[std::size_t(done) + i] = limb_t(detail::load_le(reinterpret_cast<const unsigned char*>(dst) + i * sizeof(limb_t), sizeof(limb_t)));
+			done += step;
+		}
+		if ((n && !result.mag.back()) || (!n && header[3]))
+			throw std::invalid_argument("Unsupported binary BigInt record.");
+		result.sign = !header[3];
+		return result;
+	}
+
+	template<unsigned base>
+	BigInt<base>::BigInt(const string& _str)
+	{
 		auto i = _str.begin();
-		if (*i == '+' || *i == '-') sign = (*i++ == '+');
-		for (; i != _str.end(); ++i)
-			if ('0' > *i || *i > '9')
-				throw new exception("Initiallization string contains illegal characters.");
-		str = (!(*(_str.begin()) == '+' || *(_str.begin()) == '-') ? _str : _str.substr(1));
-		while (*(str.begin()) == '0' && str.begin()+1 != str.end()) str.erase(0, 1);
+		if (i != _str.end() && (*i == '+' || *i == '-')) sign = (*i++ == '+');
+
+		detail::parse(mag, _str.data() + (i - _str.begin()), _str.end() - i, base);
+		Trim();
+	}
+
+	template<unsigned base>
+	string BigInt<base>::ToString() const
+	{
+		if (mag.empty()) return "0";
+
+		string result(sign ? "" : "-");
+		result.reserve(mag.size() * (detail::chunk_digits(base) + 1) + 1);
+		detail::format(result, mag.data(), mag.size(), 0, base);
+		return result;
 	}
 
 	template<unsigned base>
-	BigInt<base>& BigInt<base>::operator+=(const BigInt<base>& rhs)
+	BigInt<base>& BigInt<base>::AddSigned(const limb_t* rhs, std::size_t rn, bool rhsSign)
 	{
-		if (sign != rhs.sign)
+		if (!rn) return *this;
+		if (FitsWord() && rn <= 2)
 		{
-			const auto rhsModulus = rhs.Abs();
-			bool tmp = *this > rhsModulus;
-			sign = true;
-			operator-=(rhsModulus);
-			sign = tmp;
+			const std::uint64_t a = Word(), b = rn == 1 ? rhs[0] : (std::uint64_t(rhs[1]) << detail::limb_bits) | rhs[0];
+			if (sign == rhsSign || !a)
+			{
+				const std::uint64_t sum = a + b;
+				SetWord(sum, true);
+				if (sum < a)
+				{
+					mag.resize(2, 0);
+					mag.push_back(1);
+				}
+				sign = rhsSign;
+			}
+			else if (a >= b)
+				SetWord(a - b, sign);
+			else
+				SetWord(b - a, rhsSign);
 			return *this;
 		}
-
-		unsigned p = 0;
-		auto i = str.rbegin();
-		auto j = rhs.str.rbegin();
-		for (; i != str.rend(); ++i, j != rhs.str.rend() ? ++j : j)
+		if (sign == rhsSign || mag.empty())
 		{
-			unsigned tmp = *i - '0' + p + (j != rhs.str.rend() ? *j -'0' : 0);
-			*i = char(tmp % base + '0');
-			p = tmp / base;
+			sign = rhsSign;
+			if (mag.size() < rn) mag.resize(rn, 0);
+			limb_t c = detail::add(mag.data(), mag.data(), mag.size(), rhs, rn);
+			if (c) mag.push_back(c);
+			return *this;
 		}
-		if (j != rhs.str.rend())
+
+		const int c = detail::cmp(mag.data(), mag.size(), rhs, rn);
+		if (c >= 0)
+			detail::sub(mag.data(), mag.data(), mag.size(), rhs, rn);
+		else
 		{
-			auto tmp_str = string(j, rhs.str.rend());
-			std::reverse(tmp_str.begin(), tmp_str.end());
-			i = tmp_str.rbegin();
-			while (p && i != tmp_str.rend())
-			{
-				unsigned tmp = *i + p - '0';
-				*i++ = char(tmp % base + '0');
-				p = tmp / base;
-			}
-			str = tmp_str + str;
+			mag.resize(rn, 0);
+			detail::sub_n(mag.data(), rhs, mag.data(), rn);
+			sign = rhsSign;
 		}
-		if (p) str = char(p + '0') + str;
+		Trim();
 		return *this;
 	}
 
 	template<unsigned base>
-	BigInt<base>& BigInt<base>::operator-=(const BigInt<base>& rhs)
+	BigInt<base>& BigInt<base>::MulAccumulate(const BigInt<base>& lhs, const BigInt<base>& rhs, bool subtract)
 	{
-		if (*this == rhs) return (*this = Zero);
-		if (sign != rhs.sign)
+		if (lhs.mag.empty() || rhs.mag.empty()) return *this;
+		const bool productSign = (lhs.sign == rhs.sign) != subtract;
+
+		// a single limb factor is folded straight into the accumulator
+		const BigInt& wide = lhs.mag.size() >= rhs.mag.size() ? lhs : rhs;
+		const BigInt& narrow = lhs.mag.size() >= rhs.mag.size() ? rhs : lhs;
+		if (narrow.mag.size() == 1 && (sign == productSign || mag.empty()) && &wide != this)
 		{
-			sign = true;
-			*this += rhs.Abs();
-			sign = !rhs.sign;
+			const std::size_t n = wide.mag.size();
+			if (mag.size() < n) mag.resize(n, 0);
+			limb_t c = detail::addmul_1(mag.data(), wide.mag.data(), n, narrow.mag[0]);
+			c = detail::add_1(mag.data() + n, mag.data() + n, mag.size() - n, c);
+			if (c) mag.push_back(c);
+			sign = productSign;
 			return *this;
 		}
-		if (Abs() < rhs.Abs()) //throw exception("First argument must be greater or equal to second.");
+
+		detail::scratch_buffer product(lhs.mag.size() + rhs.mag.size());
+		detail::mul(product.data(), lhs.mag.data(), lhs.mag.size(), rhs.mag.data(), rhs.mag.size());
+		return AddSigned(product.data(), detail::normalized_size(product.data(), product.size()), productSign);
+	}
+
+	template<unsigned base>
+	BigInt<base>& BigInt<base>::operator*=(const BigInt<base>& rhs)
+	{
+		if (mag.empty() || rhs.mag.empty()) return (*this = Zero);
+		if (mag.size() == 1 && rhs.mag.size() == 1)
 		{
-			*this = rhs - *this;
-			sign = !sign;
+			SetWord(std::uint64_t(mag[0]) * rhs.mag[0], sign == rhs.sign);
 			return *this;
 		}
 
-		auto i = str.rbegin();
-		auto j = const_cast<BigInt<base>&>(rhs).str.rbegin();
-		for (; j != rhs.str.rend(); ++i, ++j)
-		{
-			long diff = *i - *j;
-			if (diff >= 0)
-				*i = char(diff + '0');
-			else
-			{
-				auto k = i + 1;
-				while (k != str.rend())
-				{
-					*k = char((*k - '0' + base - 1) % base + '0');
-					if (*k - '0' == base - 1)
-						++k;
-					else
-						break;
-				}
-				*i = char(diff + base + '0');
-			}
-		}
-		while (*(str.begin()) == '0' && str.begin() + 1 != str.end()) str.erase(0, 1);
+		detail::limb_vector result(mag.size() + rhs.mag.size());
+		detail::mul(result.data(), mag.data(), mag.size(), rhs.mag.data(), rhs.mag.size());
+		mag.swap(result);
+		sign = (sign == rhs.sign);
+		Trim();
 		return *this;
 	}
 
 	template<unsigned base>
-	BigInt<base>& BigInt<base>::operator*=(const BigInt<base>& rhs)
+	void BigInt<base>::DivMod(const BigInt<base>& rhs, BigInt<base>* quotient, BigInt<base>* remainder) const
 	{
-		if (*this == Zero || rhs == Zero) return (*this = Zero);
-		sign = (sign && rhs.sign) || (sign == rhs.sign);
+		if (rhs.mag.empty()) throw std::domain_error("Division by zero.");
 
-		unsigned p = 0;
-		if (str.length() == 1 && rhs.str.length() == 1)
+		// truncated division, the remainder takes the sign of the dividend
+		const bool qSign = (sign == rhs.sign), rSign = sign;
+		detail::limb_vector q, r;
+		if (FitsWord() && rhs.FitsWord())
 		{
-			p = (str[0] - '0') * (rhs.str[0] - '0');
-			str[0] = char(p % base + '0');
-			if (p >= base)
-				str = char(p / base + '0') + str;
-			return *this;
+			const std::uint64_t a = Word(), b = rhs.Word();
+			if (quotient) quotient->SetWord(a / b, qSign);
+			if (remainder) remainder->SetWord(a % b, rSign);
+			return;
+		}
+		if (CompareMagnitude(rhs) < 0)
+			r = mag;
+		else
+		{
+			q.resize(mag.size() - rhs.mag.size() + 1);
+			r.resize(rhs.mag.size());
+			detail::divrem(q.data(), r.data(), mag.data(), mag.size(), rhs.mag.data(), rhs.mag.size());
 		}
 
-		unsigned m0 = (str.length() >= rhs.str.length() ? str.length() : rhs.str.length()) / 2;
-		BigInt<base> x1(m0>str.length() ? str : string(str.end() - m0, str.end())),
-			x0(m0>str.length() ? "0" : string(str.begin(), str.end() - m0)),
-			y1(m0>rhs.str.length() ? rhs.str : string(rhs.str.end() - m0, rhs.str.end())),
-			y0(m0>rhs.str.length() ? "0" : string(rhs.str.begin(), rhs.str.end() - m0));
-		BigInt<base> p0 = x0 * y0, p1 = (x0 + x1) * (y0 + y1), p2 = x1 * y1;
-		BigInt<base> z = p1 - (p0 + p2);
-		if (p0 != Zero) p0.str.append(2 * m0, '0');
-		if (z != Zero) z.str.append(m0, '0');
-		*this = p0 + p2 + z;
-		return *this;
+		if (quotient)
+		{
+			quotient->mag.swap(q);
+			quotient->sign = qSign;
+			quotient->Trim();
+		}
+		if (remainder)
+		{
+			remainder->mag.swap(r);
+			remainder->sign = rSign;
+			remainder->Trim();
+		}
 	}
 
 	template<unsigned base>
 	BigInt<base>& BigInt<base>::operator/=(const BigInt<base>& rhs)
 	{
-		if (rhs == Zero) throw exception("Division by zero.");
-		if (*this == Zero) return *this;
-		if (Abs() < rhs.Abs()) return (*this = Zero);
+		DivMod(rhs, this, nullptr);
+		return *this;
+	}
+
+	template<unsigned base>
+	BigInt<base>& BigInt<base>::operator%=(const BigInt<base>& rhs)
+	{
+		DivMod(rhs, nullptr, this);
+		return *this;
+	}
 
-		bool tmp = (sign && rhs.sign) || (sign == rhs.sign);
-		sign = true;
-		BigInt<base> div = Zero;
+	// acc += lhs * rhs without a temporary BigInt for the product
+	template<unsigned base>
+	BigInt<base>& AddMul(BigInt<base>& acc, const BigInt<base>& lhs, const BigInt<base>& rhs)
+	{
+		return acc.MulAccumulate(lhs, rhs, false);
+	}
 
-		const auto rhsModulus = rhs.Abs();
-		while ((*this = *this - rhsModulus) >= rhsModulus)
-			div++;
-		sign = tmp;
-		return *this = (++div);
+	// acc -= lhs * rhs without a temporary BigInt for the product
+	template<unsigned base>
+	BigInt<base>& SubMul(BigInt<base>& acc, const BigInt<base>& lhs, const BigInt<base>& rhs)
+	{
+		return acc.MulAccumulate(lhs, rhs, true);
 	}
 
 	template<unsigned base>
-	BigInt<base>& BigInt<base>::operator%=(const BigInt<base>& rhs)
+	std::pair<BigInt<base>, BigInt<base>> divmod(const BigInt<base>& lhs, const BigInt<base>& rhs)
 	{
-		if (rhs == Zero) throw exception("Division by zero.");
-		if (*this == Zero) return *this;
-		
-		bool tmp = (sign && rhs.sign) || (sign == rhs.sign);
-		sign = true;
-		const auto rhsModulus = rhs.Abs();
+		std::pair<BigInt<base>, BigInt<base>> result;
+		lhs.DivMod(rhs, result.first, result.second);
+		return result;
+	}
 
-		while ((*this = *this - rhsModulus) >= rhsModulus);
-		sign = tmp;
-		return *this;
+	template<unsigned base>
+	template<typename Reduce>
+	BigInt<base> BigInt<base>::Power(const BigInt<base>& powerBase, const BigInt<base>& exponent, Reduce reduce)
+	{
+		// odd powers are precomputed for the sliding window over the exponent bits
+		std::vector<BigInt> odd(std::size_t(1) << (detail::power_window(exponent.BitLength()) - 1), powerBase);
+		if (odd.size() > 1)
+		{
+			BigInt square = powerBase * powerBase;
+			reduce(square);
+			for (std::size_t i = 1; i < odd.size(); ++i)
+			{
+				odd[i] = odd[i - 1] * square;
+				reduce(odd[i]);
+			}
+		}
+
+		BigInt result = One;
+		detail::sliding_window(exponent.mag.data(), exponent.mag.size(),
+			[&]() { if (result != One) { result *= result; reduce(result); } },
+			[&](std::size_t i) { result *= odd[i]; reduce(result); });
+		return result;
 	}
-	
+
 	template<unsigned base>
 	BigInt<base>& BigInt<base>::operator^=(const BigInt<base>& rhs)
 	{
 		if (rhs == Zero) return (*this = One);
 		if (!rhs.sign) return (*this = Zero);
-		auto power = (rhs.sign ? rhs : rhs.Abs()), powerBase = *this;
-		while (power-- != Zero) 
-			*this *= powerBase;
-		return *this;
+		return (*this = Power(*this, rhs, [](BigInt&) { }));
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::PowMod(const BigInt<base>& powerBase, const BigInt<base>& exponent, const BigInt<base>& modulus)
+	{
+		if (modulus.mag.empty()) throw std::domain_error("Division by zero.");
+		if (!exponent.sign) throw std::domain_error("Negative exponent in modular power.");
+
+		const BigInt m = modulus.Abs();
+		auto reduce = [&m](BigInt& x) { x %= m; if (!x.sign) x += m; };
+		BigInt b = powerBase;
+		reduce(b);
+		BigInt result = Power(b, exponent, reduce);
+		reduce(result);
+		return result;
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ShiftLeft(std::size_t bits) const
+	{
+		BigInt result;
+		if (mag.empty()) return result;
+		const std::size_t limbs = bits / detail::limb_bits;
+		result.mag.resize(limbs + mag.size() + 1, 0);
+		result.mag[limbs + mag.size()] = detail::lshift(result.mag.data() + limbs, mag.data(), mag.size(), unsigned(bits % detail::limb_bits));
+		result.sign = sign;
+		result.Trim();
+		return result;
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ShiftRight(std::size_t bits) const
+	{
+		BigInt result;
+		const std::size_t limbs = bits / detail::limb_bits;
+		if (limbs >= mag.size()) return result;
+		result.mag.resize(mag.size() - limbs);
+		detail::rshift(result.mag.data(), mag.data() + limbs, mag.size() - limbs, unsigned(bits % detail::limb_bits));
+		result.sign = sign;
+		result.Trim();
+		return result;
+	}
+
+	// the 64 bits of the magnitude starting at bit shift
+	template<unsigned base>
+	std::uint64_t BigInt<base>::LeadingBits(std::size_t shift) const
+	{
+		const std::size_t i = shift / detail::limb_bits;
+		const unsigned offset = unsigned(shift % detail::limb_bits);
+		auto limb = [this](std::size_t j) { return j < mag.size() ? std::uint64_t(mag[j]) : 0; };
+		std::uint64_t value = (limb(i) | (limb(i + 1) << detail::limb_bits)) >> offset;
+		if (offset) value |= limb(i + 2) << (2 * detail::limb_bits - offset);
+		return value;
+	}
+
+	/**
+	*	(x, y) = m * (x, y). With normalize, rows of m are negated where the
+	*	result would be negative and swapped so that x >= y; the matrix stays
+	*	unimodular, so the gcd of the pair is unchanged.
+	*/
+	template<unsigned base>
+	void BigInt<base>::ApplyMatrix(BigInt m[4], BigInt& x, BigInt& y, bool normalize)
+	{
+		BigInt nx = m[0] * x, ny = m[2] * x;
+		AddMul(nx, m[1], y);
+		AddMul(ny, m[3], y);
+		if (normalize)
+		{
+			if (!nx.sign) { nx.sign = true; m[0] = -std::move(m[0]); m[1] = -std::move(m[1]); }
+			if (!ny.sign) { ny.sign = true; m[2] = -std::move(m[2]); m[3] = -std::move(m[3]); }
+			if (nx < ny)
+			{
+				std::swap(nx, ny);
+				std::swap(m[0], m[2]);
+				std::swap(m[1], m[3]);
+			}
+		}
+		x = std::move(nx);
+		y = std::move(ny);
 	}
-	
+
+	// m = l * m
+	template<unsigned base>
+	void BigInt<base>::MultiplyMatrix(BigInt m[4], const BigInt l[4])
+	{
+		BigInt n0 = l[0] * m[0], n1 = l[0] * m[1], n2 = l[2] * m[0], n3 = l[2] * m[1];
+		AddMul(n0, l[1], m[2]);
+		AddMul(n1, l[1], m[3]);
+		AddMul(n2, l[3], m[2]);
+		AddMul(n3, l[3], m[3]);
+		m[0] = std::move(n0); m[1] = std::move(n1); m[2] = std::move(n2); m[3] = std::move(n3);
+	}
+
+	// one Lehmer pass on x >= y >= 0 from their leading bits, folded into m
+	template<unsigned base>
+	bool BigInt<base>::LehmerStep(BigInt& x, BigInt& y, BigInt m[4])
+	{
+		const std::size_t bits = x.BitLength(), shift = bits > 62 ? bits - 62 : 0;
+		std::int64_t l[4];
+		if (!detail::lehmer_matrix(x.LeadingBits(shift), y.LeadingBits(shift), l)) return false;
+		BigInt step[4] = { l[0], l[1], l[2], l[3] };
+		ApplyMatrix(step, x, y, true);
+		MultiplyMatrix(m, step);
+		return true;
+	}
+
+	// one Euclid step (x, y) = (y, x mod y) for x >= y > 0, folded into m
+	template<unsigned base>
+	void BigInt<base>::DivisionStep(BigInt& x, BigInt& y, BigInt m[4])
+	{
+		BigInt q, r;
+		x.DivMod(y, &q, &r);
+		x = std::move(y);
+		y = std::move(r);
+		const BigInt step[4] = { Zero, One, One, -std::move(q) };
+		MultiplyMatrix(m, step);
+	}
+
+	/**
+	*	Half-gcd for a >= b >= 0: m such that m * (a, b) is about half as long
+	*	as a, found recursively from the leading limbs. Reducing the top half of
+	*	the operands by half reduces the whole by a quarter, two such rounds give
+	*	the half with multiplications only of size n by n / 4.
+	*/
+	template<unsigned base>
+	void BigInt<base>::HalfGcd(const BigInt& a, const BigInt& b, BigInt m[4])
+	{
+		const std::size_t n = a.mag.size(), target = n / 2 + 1;
+		m[0] = One; m[1] = Zero; m[2] = Zero; m[3] = One;
+		BigInt x(a), y(b);
+		if (n >= detail::hgcd_threshold)
+		{
+			HalfGcd(a.ShiftRight((n / 2) * detail::limb_bits), b.ShiftRight((n / 2) * detail::limb_bits), m);
+			ApplyMatrix(m, x, y, true);
+			if (y.mag.size() > target && x.mag.size() > target)
+			{
+				// the leading 2 (l - target) limbs of x carry the reduction down to the target
+				const std::size_t l = x.mag.size(), k = l > 2 * (l - target) ? l - 2 * (l - target) : 0;
+				BigInt s[4];
+				HalfGcd(x.ShiftRight(k * detail::limb_bits), y.ShiftRight(k * detail::limb_bits), s);
+				ApplyMatrix(s, x, y, true);
+				MultiplyMatrix(m, s);
+			}
+		}
+		while (y.mag.size() > target)
+			if (!LehmerStep(x, y, m)) DivisionStep(x, y, m);
+	}
+
+	// gcd of a, b >= 0; cofactor, if given, receives u with u * a = gcd (mod b)
+	template<unsigned base>
+	BigInt<base> BigInt<base>::GcdMagnitude(BigInt a, BigInt b, BigInt* cofactor)
+	{
+		BigInt u0 = One, u1 = Zero;
+		if (a < b)
+		{
+			std::swap(a, b);
+			std::swap(u0, u1);
+		}
+		while (!b.mag.empty())
+		{
+			BigInt m[4] = { One, Zero, Zero, One };
+			if (a.mag.size() > b.mag.size() + 1 || b.FitsWord())
+				DivisionStep(a, b, m);
+			else if (b.mag.size() >= detail::hgcd_threshold)
+			{
+				const std::size_t before = b.mag.size();
+				HalfGcd(a, b, m);
+				ApplyMatrix(m, a, b, true);
+				if (b.mag.size() == before && !b.mag.empty())
+				{
+					if (cofactor) ApplyMatrix(m, u0, u1, false);
+					m[0] = One; m[1] = Zero; m[2] = Zero; m[3] = One;
+					DivisionStep(a, b, m);
+				}
+			}
+			else if (!LehmerStep(a, b, m))
+				DivisionStep(a, b, m);
+			if (cofactor) ApplyMatrix(m, u0, u1, false);
+		}
+		if (cofactor) *cofactor = std::move(u0);
+		return a;
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::Gcd(const BigInt<base>& lhs, const BigInt<base>& rhs)
+	{
+		if (lhs.FitsWord() && rhs.FitsWord()) return BigInt(std::gcd(lhs.Word(), rhs.Word()));
+		return GcdMagnitude(lhs.Abs(), rhs.Abs(), nullptr);
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ExtGcd(const BigInt<base>& lhs, const BigInt<base>& rhs, BigInt<base>& x, BigInt<base>& y)
+	{
+		BigInt u;
+		BigInt g = GcdMagnitude(lhs.Abs(), rhs.Abs(), &u);
+		if (rhs.mag.empty())
+		{
+			x = lhs.mag.empty() ? Zero : lhs.sign ? One : -One;
+			y = Zero;
+			return g;
+		}
+
+		// u * |lhs| = g (mod |rhs|), reduced to the smallest non-negative coefficient
+		if (!lhs.sign) u = -std::move(u);
+		const BigInt period = rhs.Abs() / g;
+		u %= period;
+		if (!u.sign) u += period;
+		BigInt v = (g - lhs * u) / rhs;
+		x = std::move(u);
+		y = std::move(v);
+		return g;
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ModInverse(const BigInt<base>& value, const BigInt<base>& modulus)
+	{
+		if (modulus.mag.empty()) throw std::domain_error("Division by zero.");
+		BigInt x, y;
+		if (ExtGcd(value, modulus, x, y) != One) throw std::domain_error("Value is not invertible modulo the modulus.");
+		return x;
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::ISqrt(const BigInt<base>& value)
+	{
+		if (!value.sign) throw std::domain_error("Square root of negative number.");
+		if (value.FitsWord()) return BigInt(detail::isqrt_word(value.Word()));
+
+		// (isqrt(value >> 2k) + 1) << k is above the root by about 2^k, Newton from above descends to the floor
+		const std::size_t k = value.BitLength() / 4;
+		BigInt x = (ISqrt(value.ShiftRight(2 * k)) + 1).ShiftLeft(k);
+		for (;;)
+		{
+			BigInt y = (x + value / x).ShiftRight(1);
+			if (!(y < x)) return x;
+			x = std::move(y);
+		}
+	}
+
+	template<unsigned base>
+	BigInt<base> BigInt<base>::IRoot(const BigInt<base>& value, unsigned k)
+	{
+		if (!k) throw std::domain_error("Zeroth root.");
+		if (!value.sign)
+		{
+			if (k % 2 == 0) throw std::domain_error("Even root of negative number.");
+			return -IRoot(-value, k);
+		}
+		if (k == 1) return value;
+		if (k == 2) return ISqrt(value);
+
+		const std::size_t bits = value.BitLength(), s = bits / (2 * k);
+		if (bits <= k) return value.mag.empty() ? Zero : One;
+		BigInt x = s ? (IRoot(value.ShiftRight(k * s), k) + 1).ShiftLeft(s) : One.ShiftLeft((bits + k - 1) / k);
+		const BigInt degree(k), power(k - 1);
+		for (;;)
+		{
+			BigInt y = (x * power + value / (x ^ power)) / degree;
+			if (!(y < x)) return x;
+			x = std::move(y);
+		}
+	}
+
 }
 
 using BigInt = gasper::BigInt<10>;
@@ -0,0 +1,172 @@
+#ifndef BIGINTARRAY_H
+#define BIGINTARRAY_H
+
+#include "BigInt.h"
+#include<fstream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#endif
+
+namespace gasper {
+
+	/**
+	*	Read-only, memory-mapped table of BigInt values.
+	*
+	*	The file starts with "GBIA", the format version as 32-bit and the value
+	*	count as 64-bit integer, followed by count + 1 64-bit byte offsets of the
+	*	records (the last one is the file size) and the records themselves in
+	*	the format of BigInt::WriteBinary. Entries point straight into the
+	*	mapping, so opening a table costs neither parsing nor copying.
+	*/
+	class BigIntArray
+	{
+		typedef detail::limb_t limb_t;
+
+	public:
+		// a stored value, valid as long as the array is open
+		struct Entry
+		{
+			const limb_t* limbs;
+			std::size_t size;
+			bool negative;
+
+			template<unsigned base = 10> BigInt<base> ToBigInt() const
+			{
+				BigInt<base> result;
+				result.mag.assign(limbs, limbs + size);
+				result.sign = !negative;
+				return result;
+			}
+		};
+
+		explicit BigIntArray(const string& path);
+		BigIntArray(BigIntArray&& other) noexcept : data(other.data), bytes(other.bytes), count(other.count) { other.data = nullptr; }
+		BigIntArray(const BigIntArray&) = delete;
+		BigIntArray& operator=(const BigIntArray&) = delete;
+		~BigIntArray() { Unmap(); }
+
+		inline std::size_t Size() const { return count; }
+		Entry operator[](std::size_t i) const;
+		template<unsigned base = 10> inline BigInt<base> Get(std::size_t i) const { return (*this)[i].template ToBigInt<base>(); }
+
+		template<unsigned base> static void Write(const string& path, const std::vector<BigInt<base>>& values);
+
+	private:
+		const unsigned char* data = nullptr;
+		std::size_t bytes = 0, count = 0;
+
+		static const std::uint32_t version = 1;
+		static const std::size_t header_size = 16;
+
+		inline std::uint64_t Offset(std::size_t i) const { return detail::load_le(data + header_size + 8 * i, 8); }
+		void Unmap();
+	};
+
+	inline BigIntArray::BigIntArray(const string& path)
+	{
+		if (!detail::little_endian_host())
+			throw std::runtime_error("BigIntArray requires a little-endian host.");
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path + ".");
+		LARGE_INTEGER size;
+		HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		if (mapping)
+		{
+			data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		bytes = data ? std::size_t(size.QuadPart) : 0;
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) throw std::runtime_error("Cannot open " + path + ".");
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* p = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+			if (p != MAP_FAILED)
+			{
+				data = static_cast<const unsigned char*>(p);
+				bytes = std::size_t(info.st_size);
+			}
+		}
+		close(file);
+#endif
+		if (!data) throw std::runtime_error("Cannot map " + path + ".");
+
+		// only the index is checked here, records are validated when accessed
+		const bool valid = bytes >= header_size && std::memcmp(data, "GBIA", 4) == 0 && detail::load_le(data + 4, 4) == version;
+		count = valid ? std::size_t(detail::load_le(data + 8, 8)) : 0;
+		if (!valid || count >= (bytes - header_size) / 8 || Offset(count) != bytes)
+		{
+			Unmap();
+			throw std::invalid_argument("Unsupported BigIntArray file " + path + ".");
+		}
+	}
+
+	inline void BigIntArray::Unmap()
+	{
+		if (!data) return;
+#if defined(_WIN32)
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<unsigned char*>(data), bytes);
+#endif
+		data = nullptr;
+	}
+
+	inline BigIntArray::Entry BigIntArray::operator[](std::size_t i) const
+	{
+		if (i >= count) throw std::out_of_range("BigIntArray index out of range.");
+		const std::uint64_t begin = Offset(i), end = Offset(i + 1);
+		const unsigned char* record = data + begin;
+		if (begin > end || end > bytes || end - begin < detail::binary_header_size || begin % sizeof(limb_t)
+			|| record[0] != 'G' || record[1] != 'B' || record[2] != detail::binary_version || record[3] > 1
+			|| detail::load_le(record + 4, 8) != (end - begin - detail::binary_header_size) / sizeof(limb_t))
+			throw std::invalid_argument("Corrupt BigIntArray record.");
+		Entry entry;
+		entry.limbs = reinterpret_cast<const limb_t*>(record + detail::binary_header_size);
+		entry.size = std::size_t((end - begin - detail::binary_header_size) / sizeof(limb_t));
+		entry.negative = record[3] != 0;
+		// the same normal form ReadBinary requires
+		if ((entry.size && !entry.limbs[entry.size - 1]) || (entry.negative && !entry.size))
+			throw std::invalid_argument("Corrupt BigIntArray record.");
+		return entry;
+	}
+
+	template<unsigned base>
+	void BigIntArray::Write(const string& path, const std::vector<BigInt<base>>& values)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out) throw std::runtime_error("Cannot open " + path + ".");
+
+		unsigned char header[header_size] = { 'G', 'B', 'I', 'A' };
+		detail::store_le(header + 4, version, 4);
+		detail::store_le(header + 8, values.size(), 8);
+		out.write(reinterpret_cast<const char*>(header), sizeof header);
+
+		std::uint64_t offset = header_size + 8 * (values.size() + 1);
+		unsigned char field[8];
+		for (std::size_t i = 0; i <= values.size(); ++i)
+		{
+			detail::store_le(field, offset, 8);
+			out.write(reinterpret_cast<const char*>(field), sizeof field);
+			if (i < values.size()) offset += detail::binary_header_size + values[i].mag.size() * sizeof(limb_t);
+		}
+		for (const BigInt<base>& value : values) value.WriteBinary(out);
+		if (!out.flush()) throw std::runtime_error("Cannot write " + path + ".");
+	}
+
+}
+
+#endif // !BIGINTARRAY_H
@@ -0,0 +1,162 @@
+#ifndef BIGINTBATCH_H
+#define BIGINTBATCH_H
+
+#include "BigInt.h"
+
+namespace gasper {
+
+	/**
+	*	Execution policy of the batch operations. Parallel spreads independent
+	*	tree nodes over the thread pool configured with SetBigIntThreads; the
+	*	results are the same as with Sequential.
+	*/
+	enum class Execution { Sequential, Parallel };
+
+	namespace detail {
+
+		// f(i) for i in [0, n), in contiguous chunks on the pool when parallel
+		template<typename F>
+		void parallel_for(std::size_t n, F f, Execution policy)
+		{
+			const std::size_t chunks = policy == Execution::Parallel ? std::min<std::size_t>(n, 4 * thread_pool::instance().threads()) : 1;
+			if (chunks < 2)
+			{
+				for (std::size_t i = 0; i < n; ++i) f(i);
+				return;
+			}
+			task_group g;
+			for (std::size_t c = 1; c < chunks; ++c)
+				g.run([=, &f] { for (std::size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) f(i); });
+			for (std::size_t i = 0; i < n / chunks; ++i) f(i);
+			g.wait();
+		}
+
+		// balanced combination of v[n], halves are independent and may run in parallel
+		template<unsigned base, typename Combine>
+		BigInt<base> tree_reduce(const BigInt<base>* v, std::size_t n, Combine combine, Execution policy)
+		{
+			if (n == 1) return v[0];
+			const std::size_t half = n / 2;
+			BigInt<base> lhs, rhs;
+			if (policy == Execution::Parallel && n >= 4)
+			{
+				task_group g;
+				g.run([&] { rhs = tree_reduce(v + half, n - half, combine, policy); });
+				lhs = tree_reduce(v, half, combine, policy);
+				g.wait();
+			}
+			else
+			{
+				lhs = tree_reduce(v, half, combine, policy);
+				rhs = tree_reduce(v + half, n - half, combine, policy);
+			}
+			combine(lhs, std::move(rhs));
+			return lhs;
+		}
+
+	}
+
+	/**
+	*	Product of all values, multiplied as a balanced binary tree so operands
+	*	of each multiplication have similar sizes and the fast multiplication
+	*	algorithms apply. The empty product is one.
+	*/
+	template<unsigned base>
+	BigInt<base> Product(const std::vector<BigInt<base>>& values, Execution policy = Execution::Sequential)
+	{
+		if (values.empty()) return BigInt<base>::One;
+		return detail::tree_reduce(values.data(), values.size(), [](BigInt<base>& lhs, BigInt<base>&& rhs) { lhs *= rhs; }, policy);
+	}
+
+	// sum of all values, added pairwise as a balanced tree
+	template<unsigned base>
+	BigInt<base> Sum(const std::vector<BigInt<base>>& values, Execution policy = Execution::Sequential)
+	{
+		if (values.empty()) return BigInt<base>::Zero;
+		return detail::tree_reduce(values.data(), values.size(), [](BigInt<base>& lhs, BigInt<base>&& rhs) { lhs += rhs; }, policy);
+	}
+
+	/**
+	*	value % moduli[i] for every modulus, with the semantics of operator%.
+	*	The moduli are multiplied up into a product tree, then value is reduced
+	*	down the tree so that each division only sees operands about twice the
+	*	size of the divisor, instead of dividing the full value by every modulus.
+	*/
+	template<unsigned base>
+	std::vector<BigInt<base>> Remainders(const BigInt<base>& value, const std::vector<BigInt<base>>& moduli, Execution policy = Execution::Sequential)
+	{
+		if (moduli.empty()) return std::vector<BigInt<base>>();
+
+		// levels[0] are the moduli, each node of levels[i + 1] the product of two in levels[i]
+		std::vector<std::vector<BigInt<base>>> levels(1, moduli);
+		while (levels.back().size() > 1)
+		{
+			const std::vector<BigInt<base>>& below = levels.back();
+			std::vector<BigInt<base>> above((below.size() + 1) / 2);
+			detail::parallel_for(above.size(), [&](std::size_t i)
+			{
+				above[i] = 2 * i + 1 < below.size() ? below[2 * i] * below[2 * i + 1] : below[2 * i];
+			}, policy);
+			levels.push_back(std::move(above));
+		}
+
+		std::vector<BigInt<base>> remainders(1, value % levels.back()[0]);
+		for (std::size_t l = levels.size() - 1; l--; )
+		{
+			const std::vector<BigInt<base>>& nodes = levels[l];
+			std::vector<BigInt<base>> next(nodes.size());
+			detail::parallel_for(nodes.size(), [&](std::size_t i) { next[i] = remainders[i / 2] % nodes[i]; }, policy);
+			remainders.swap(next);
+		}
+		return remainders;
+	}
+
+	/**
+	*	Running sum that adds values pairwise: like a binary counter, slot i
+	*	holds the sum of 2^i values, so every addition combines partial sums
+	*	built from equally many inputs.
+	*/
+	template<unsigned base>
+	class BigIntAccumulator
+	{
+	public:
+		void Add(BigInt<base> value)
+		{
+			std::size_t i = 0;
+			for (; i < slots.size() && used[i]; ++i)
+			{
+				value += slots[i];
+				used[i] = false;
+			}
+			if (i == slots.size())
+			{
+				slots.emplace_back();
+				used.push_back(false);
+			}
+			slots[i] = std::move(value);
+			used[i] = true;
+		}
+		inline BigIntAccumulator& operator+=(const BigInt<base>& value) { Add(value); return *this; }
+
+		BigInt<base> Total() const
+		{
+			BigInt<base> total;
+			for (std::size_t i = 0; i < slots.size(); ++i)
+				if (used[i]) total += slots[i];
+			return total;
+		}
+
+		void Clear()
+		{
+			slots.clear();
+			used.clear();
+		}
+
+	private:
+		std::vector<BigInt<base>> slots;
+		std::vector<bool> used;
+	};
+
+}
+
+#endif // !BIGINTBATCH_H
@@ -0,0 +1,347 @@
+#ifndef FIXEDBIGINT_H
+#define FIXEDBIGINT_H
+
+#include "BigInt.h"
+
+namespace gasper {
+
+	/**
+	*	Unsigned integer of a fixed number of bits whose arithmetic wraps modulo
+	*	2^bits like the built-in unsigned types.
+	*
+	*	The limbs are stored inline and every operation is constexpr, looping over
+	*	the compile-time limb count, so nothing is allocated and the compiler can
+	*	unroll and inline the arithmetic. The interface follows BigInt: ^ is the
+	*	power and base is only the radix for strings. For hashing there are the
+	*	bitwise &, |, ~, << and >>, with exclusive or named Xor and XorWith.
+	*/
+	template<std::size_t bits, unsigned base = 10>
+	class FixedBigInt
+	{
+		static_assert(bits && bits % detail::limb_bits == 0, "FixedBigInt bits must be a positive multiple of the limb size.");
+		static_assert(base >= 2 && base <= 36, "FixedBigInt base must be in range [2, 36].");
+		template<std::size_t, unsigned> friend class FixedBigInt;
+		typedef detail::limb_t limb_t;
+		typedef detail::dlimb_t dlimb_t;
+
+		static constexpr std::size_t n = bits / detail::limb_bits;
+		static constexpr unsigned limb_bits = detail::limb_bits;
+
+	public:
+		const static FixedBigInt Zero;
+		const static FixedBigInt One;
+
+		constexpr FixedBigInt() { }
+		constexpr FixedBigInt(const char* _str) : FixedBigInt(_str, std::char_traits<char>::length(_str)) { }
+		FixedBigInt(const string& _str) : FixedBigInt(_str.data(), _str.size()) { }
+		template<typename T> constexpr FixedBigInt(T _num)
+		{
+			static_assert(std::is_integral<T>::value, "Cannot construct FixedBigInt from provided type.");
+			// negative values wrap around as in two's complement
+			const unsigned long long num = static_cast<unsigned long long>(_num);
+			for (std::size_t i = 0; i < n; ++i)
+				limb[i] = i < 2 ? limb_t(num >> (i * limb_bits)) : _num < T(0) ? ~limb_t(0) : 0;
+		}
+		// values out of range are reduced modulo 2^bits
+		template<unsigned rBase> explicit FixedBigInt(const BigInt<rBase>& rhs)
+		{
+			for (std::size_t i = 0; i < n && i < rhs.mag.size(); ++i) limb[i] = rhs.mag[i];
+			if (!rhs.sign) Negate();
+		}
+		template<std::size_t rBits, unsigned rBase> explicit constexpr FixedBigInt(const FixedBigInt<rBits, rBase>& rhs)
+		{
+			for (std::size_t i = 0; i < n && i < rhs.n; ++i) limb[i] = rhs.limb[i];
+		}
+
+		friend constexpr bool operator==(const FixedBigInt& lhs, const FixedBigInt& rhs)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				if (lhs.limb[i] != rhs.limb[i]) return false;
+			return true;
+		}
+		friend constexpr bool operator<(const FixedBigInt& lhs, const FixedBigInt& rhs)
+		{
+			for (std::size_t i = n; i--; )
+				if (lhs.limb[i] != rhs.limb[i]) return lhs.limb[i] < rhs.limb[i];
+			return false;
+		}
+		friend constexpr bool operator!=(const FixedBigInt& lhs, const FixedBigInt& rhs) { return !(lhs == rhs); }
+		friend constexpr bool operator>(const FixedBigInt& lhs, const FixedBigInt& rhs) { return rhs < lhs; }
+		friend constexpr bool operator<=(const FixedBigInt& lhs, const FixedBigInt& rhs) { return !(rhs < lhs); }
+		friend constexpr bool operator>=(const FixedBigInt& lhs, const FixedBigInt& rhs) { return !(lhs < rhs); }
+
+		constexpr FixedBigInt& operator+=(const FixedBigInt& rhs)
+		{
+			dlimb_t carry = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				carry += dlimb_t(limb[i]) + rhs.limb[i];
+				limb[i] = limb_t(carry);
+				carry >>= limb_bits;
+			}
+			return *this;
+		}
+		constexpr FixedBigInt& operator-=(const FixedBigInt& rhs)
+		{
+			limb_t borrow = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				const dlimb_t d = dlimb_t(limb[i]) - rhs.limb[i] - borrow;
+				limb[i] = limb_t(d);
+				borrow = limb_t(d >> limb_bits) & 1;
+			}
+			return *this;
+		}
+		// schoolbook product truncated to the low n limbs
+		constexpr FixedBigInt& operator*=(const FixedBigInt& rhs)
+		{
+			limb_t r[n] = {};
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				dlimb_t carry = 0;
+				for (std::size_t j = 0; i + j < n; ++j)
+				{
+					carry += dlimb_t(limb[i]) * rhs.limb[j] + r[i + j];
+					r[i + j] = limb_t(carry);
+					carry >>= limb_bits;
+				}
+			}
+			for (std::size_t i = 0; i < n; ++i) limb[i] = r[i];
+			return *this;
+		}
+		constexpr FixedBigInt& operator/=(const FixedBigInt& rhs) { FixedBigInt r; DivMod(rhs, *this, r); return *this; }
+		constexpr FixedBigInt& operator%=(const FixedBigInt& rhs) { FixedBigInt q; DivMod(rhs, q, *this); return *this; }
+		constexpr FixedBigInt& operator^=(const FixedBigInt& rhs)
+		{
+			FixedBigInt result = One;
+			for (std::size_t i = rhs.BitLength(); i--; )
+			{
+				result *= result;
+				if (rhs.TestBit(i)) result *= *this;
+			}
+			return *this = result;
+		}
+
+		constexpr FixedBigInt& operator&=(const FixedBigInt& rhs) { for (std::size_t i = 0; i < n; ++i) limb[i] &= rhs.limb[i]; return *this; }
+		constexpr FixedBigInt& operator|=(const FixedBigInt& rhs) { for (std::size_t i = 0; i < n; ++i) limb[i] |= rhs.limb[i]; return *this; }
+		constexpr FixedBigInt& XorWith(const FixedBigInt& rhs) { for (std::size_t i = 0; i < n; ++i) limb[i] ^= rhs.limb[i]; return *this; }
+		inline constexpr FixedBigInt Xor(const FixedBigInt& rhs) const { FixedBigInt tmp(*this); return tmp.XorWith(rhs); }
+		constexpr FixedBigInt& operator<<=(std::size_t shift)
+		{
+			const std::size_t w = shift / limb_bits, s = shift % limb_bits;
+			for (std::size_t i = n; i--; )
+			{
+				const limb_t hi = i >= w ? limb[i - w] : 0, lo = i > w ? limb[i - w - 1] : 0;
+				limb[i] = s ? (hi << s) | (lo >> (limb_bits - s)) : hi;
+			}
+			return *this;
+		}
+		constexpr FixedBigInt& operator>>=(std::size_t shift)
+		{
+			const std::size_t w = shift / limb_bits, s = shift % limb_bits;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				const limb_t lo = i + w < n ? limb[i + w] : 0, hi = i + w + 1 < n ? limb[i + w + 1] : 0;
+				limb[i] = s ? (lo >> s) | (hi << (limb_bits - s)) : lo;
+			}
+			return *this;
+		}
+
+		inline constexpr FixedBigInt& operator++() { return *this += One; }
+		inline constexpr FixedBigInt operator++(int) { FixedBigInt tmp(*this); operator++(); return tmp; }
+		inline constexpr FixedBigInt& operator--() { return *this -= One; }
+		inline constexpr FixedBigInt operator--(int) { FixedBigInt tmp(*this); operator--(); return tmp; }
+		inline constexpr FixedBigInt operator-() const { FixedBigInt tmp(*this); tmp.Negate(); return tmp; }
+		inline constexpr FixedBigInt operator~() const { FixedBigInt tmp(*this); for (limb_t& x : tmp.limb) x = ~x; return tmp; }
+
+		friend constexpr FixedBigInt operator+(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs += rhs; }
+		friend constexpr FixedBigInt operator-(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs -= rhs; }
+		friend constexpr FixedBigInt operator*(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs *= rhs; }
+		friend constexpr FixedBigInt operator/(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs /= rhs; }
+		friend constexpr FixedBigInt operator%(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs %= rhs; }
+		friend constexpr FixedBigInt operator^(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs ^= rhs; }
+		friend constexpr FixedBigInt operator&(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs &= rhs; }
+		friend constexpr FixedBigInt operator|(FixedBigInt lhs, const FixedBigInt& rhs) { return lhs |= rhs; }
+		friend constexpr FixedBigInt operator<<(FixedBigInt lhs, std::size_t shift) { return lhs <<= shift; }
+		friend constexpr FixedBigInt operator>>(FixedBigInt lhs, std::size_t shift) { return lhs >>= shift; }
+
+		string ToString() const
+		{
+			string result;
+			detail::format(result, limb, n, 0, base);
+			return result.empty() ? "0" : result;
+		}
+		inline explicit operator string() const { return ToString(); }
+		BigInt<base> ToBigInt() const
+		{
+			BigInt<base> result;
+			result.mag.assign(limb, limb + n);
+			result.Trim();
+			return result;
+		}
+
+		inline unsigned Base() const { return base; }
+		inline string BaseAsString() const { return std::to_string(base); }
+		template<unsigned toBase> inline constexpr FixedBigInt<bits, toBase> ToBase() const { return FixedBigInt<bits, toBase>(*this); }
+
+		constexpr void DivMod(const FixedBigInt& rhs, FixedBigInt& quotient, FixedBigInt& remainder) const
+		{
+			limb_t q[n] = {}, r[n] = {};
+			DivRem(limb, rhs.limb, q, r);
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				quotient.limb[i] = q[i];
+				remainder.limb[i] = r[i];
+			}
+		}
+		// the products are reduced at twice the width, so nothing wraps
+		static constexpr FixedBigInt PowMod(const FixedBigInt& powerBase, const FixedBigInt& exponent, const FixedBigInt& modulus)
+		{
+			typedef FixedBigInt<2 * bits, base> Wide;
+			const Wide m(modulus);
+			const Wide x = Wide(powerBase) % m;
+			Wide result = Wide::One % m;
+			for (std::size_t i = exponent.BitLength(); i--; )
+			{
+				result = result * result % m;
+				if (exponent.TestBit(i)) result = result * x % m;
+			}
+			return FixedBigInt(result);
+		}
+
+	private:
+		limb_t limb[n] = {};
+
+		constexpr FixedBigInt(const char* s, std::size_t len)
+		{
+			const bool negative = len && *s == '-';
+			if (len && (*s == '+' || *s == '-')) ++s, --len;
+			for (; len; ++s, --len)
+			{
+				const unsigned d = detail::digit_value(*s);
+				if (d >= base)
+					throw std::invalid_argument("Initiallization string contains illegal characters.");
+				dlimb_t carry = d;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					carry += dlimb_t(limb[i]) * base;
+					limb[i] = limb_t(carry);
+					carry >>= limb_bits;
+				}
+			}
+			if (negative) Negate();
+		}
+
+		constexpr void Negate()
+		{
+			dlimb_t carry = 1;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				carry += limb_t(~limb[i]);
+				limb[i] = limb_t(carry);
+				carry >>= limb_bits;
+			}
+		}
+
+		constexpr std::size_t BitLength() const
+		{
+			for (std::size_t i = n; i--; )
+				if (limb[i]) return (i + 1) * limb_bits - detail::leading_zeros(limb[i]);
+			return 0;
+		}
+		constexpr bool TestBit(std::size_t i) const { return (limb[i / limb_bits] >> (i % limb_bits)) & 1; }
+
+		// q[n], r[n] = u / v, u % v by Knuth's algorithm D on the fixed-size limbs
+		static constexpr void DivRem(const limb_t* u, const limb_t* v, limb_t* q, limb_t* r)
+		{
+			std::size_t un = n, vn = n;
+			while (un && !u[un - 1]) --un;
+			while (vn && !v[vn - 1]) --vn;
+			if (!vn) throw std::domain_error("Division by zero.");
+			if (un < vn)
+			{
+				for (std::size_t i = 0; i < n; ++i) r[i] = u[i];
+				return;
+			}
+			if (vn == 1)
+			{
+				dlimb_t rem = 0;
+				for (std::size_t i = un; i--; )
+				{
+					rem = (rem << limb_bits) | u[i];
+					q[i] = limb_t(rem / v[0]);
+					rem %= v[0];
+				}
+				r[0] = limb_t(rem);
+				return;
+			}
+
+			// normalize so the top divisor limb has its high bit set
+			const unsigned s = detail::leading_zeros(v[vn - 1]);
+			limb_t vs[n] = {}, us[n + 1] = {};
+			for (std::size_t i = 0; i < vn; ++i) vs[i] = (v[i] << s) | (s && i ? v[i - 1] >> (limb_bits - s) : 0);
+			for (std::size_t i = 0; i < un; ++i) us[i] = (u[i] << s) | (s && i ? u[i - 1] >> (limb_bits - s) : 0);
+			us[un] = s ? u[un - 1] >> (limb_bits - s) : 0;
+
+			for (std::size_t j = un - vn + 1; j--; )
+			{
+				const dlimb_t top = (dlimb_t(us[j + vn]) << limb_bits) | us[j + vn - 1];
+				dlimb_t qhat = top / vs[vn - 1], rhat = top % vs[vn - 1];
+				while (qhat >> limb_bits || qhat * vs[vn - 2] > ((rhat << limb_bits) | us[j + vn - 2]))
+				{
+					--qhat;
+					rhat += vs[vn - 1];
+					if (rhat >> limb_bits) break;
+				}
+
+				dlimb_t carry = 0;
+				limb_t borrow = 0;
+				for (std::size_t i = 0; i < vn; ++i)
+				{
+					const dlimb_t p = qhat * vs[i] + carry;
+					carry = p >> limb_bits;
+					const dlimb_t d = dlimb_t(us[i + j]) - limb_t(p) - borrow;
+					us[i + j] = limb_t(d);
+					borrow = limb_t(d >> limb_bits) & 1;
+				}
+				const dlimb_t d = dlimb_t(us[j + vn]) - carry - borrow;
+				us[j + vn] = limb_t(d);
+				if (d >> limb_bits)
+				{
+					// qhat was one too large, add the divisor back
+					--qhat;
+					carry = 0;
+					for (std::size_t i = 0; i < vn; ++i)
+					{
+						carry += dlimb_t(us[i + j]) + vs[i];
+						us[i + j] = limb_t(carry);
+						carry >>= limb_bits;
+					}
+					us[j + vn] += limb_t(carry);
+				}
+				q[j] = limb_t(qhat);
+			}
+			for (std::size_t i = 0; i < vn; ++i) r[i] = (us[i] >> s) | (s ? us[i + 1] << (limb_bits - s) : 0);
+		}
+	};
+
+	template<std::size_t bits, unsigned base> constexpr FixedBigInt<bits, base> FixedBigInt<bits, base>::Zero = FixedBigInt<bits, base>(0);
+	template<std::size_t bits, unsigned base> constexpr FixedBigInt<bits, base> FixedBigInt<bits, base>::One = FixedBigInt<bits, base>(1);
+
+	template<std::size_t bits, unsigned base>
+	std::ostream& operator<<(std::ostream& os, const FixedBigInt<bits, base>& obj)
+	{
+		return os << obj.ToString();
+	}
+
+	template<std::size_t bits, unsigned base>
+	std::istream& operator>>(std::istream& is, FixedBigInt<bits, base>& obj)
+	{
+		BigInt<base> value;
+		if (is >> value) obj = FixedBigInt<bits, base>(value);
+		return is;
+	}
+
+}
+
+#endif // !FIXEDBIGINT_H
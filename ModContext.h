@@ -0,0 +1,244 @@
+#ifndef MODCONTEXT_H
+#define MODCONTEXT_H
+
+#include "BigInt.h"
+
+namespace gasper {
+
+	/**
+	*	Modular arithmetic with a fixed modulus.
+	*
+	*	The constructor divides once to precompute the Barrett constant
+	*	floor(B^2n / m) and, for odd moduli, the Montgomery constants -m^-1 mod B
+	*	and R^2 mod m with R = B^n. After that reductions only multiply: single
+	*	MulMod/SqrMod/Reduce calls use Barrett reduction, PowMod keeps its chain in
+	*	Montgomery form when the modulus is odd. Results are in [0, |modulus|).
+	*/
+	template<unsigned base>
+	class ModContext
+	{
+		typedef detail::limb_t limb_t;
+
+	public:
+		explicit ModContext(const BigInt<base>& _modulus);
+
+		inline const BigInt<base>& Modulus() const { return modulus; }
+		inline bool IsMontgomery() const { return montgomery; }
+
+		BigInt<base> Reduce(const BigInt<base>& x) const;
+		void Reduce(std::vector<BigInt<base>>& values) const;
+		BigInt<base> MulMod(const BigInt<base>& lhs, const BigInt<base>& rhs) const;
+		inline BigInt<base> SqrMod(const BigInt<base>& x) const { return MulMod(x, x); }
+		BigInt<base> PowMod(const BigInt<base>& powerBase, const BigInt<base>& exponent) const;
+
+	private:
+		BigInt<base> modulus;
+		std::size_t n;
+		bool montgomery;
+		limb_t inv = 0;
+		std::vector<limb_t> mu, r2;
+
+		inline const limb_t* M() const { return modulus.mag.data(); }
+		void Barrett(const limb_t* x, std::size_t xn, limb_t* out, limb_t* scratch) const;
+		void Redc(limb_t* t, limb_t* out) const;
+		void MulReduce(const limb_t* a, const limb_t* b, limb_t* out, limb_t* scratch, bool useMontgomery) const;
+		void ToResidue(const BigInt<base>& x, limb_t* out, limb_t* scratch) const;
+		BigInt<base> FromResidue(const limb_t* r) const;
+
+		// limbs of scratch needed by Barrett and MulReduce
+		inline std::size_t ScratchSize() const { return 7 * n + 8; }
+	};
+
+	template<unsigned base>
+	ModContext<base>::ModContext(const BigInt<base>& _modulus) : modulus(_modulus.Abs()), n(modulus.mag.size())
+	{
+		if (!n) throw std::domain_error("Division by zero.");
+		montgomery = modulus.mag[0] & 1;
+
+		// B^2n = mu * m + r2, which also is R^2 mod m
+		detail::limb_vector power(2 * n + 1, 0);
+		power[2 * n] = 1;
+		mu.resize(n + 2);
+		r2.resize(n);
+		detail::divrem(mu.data(), r2.data(), power.data(), power.size(), M(), n);
+
+		if (montgomery)
+		{
+			// Newton iteration for m^-1 mod B, each step doubles the correct bits
+			limb_t x = M()[0];
+			for (int i = 0; i < 4; ++i) x *= 2 - M()[0] * x;
+			inv = limb_t(0) - x;
+		}
+	}
+
+	// out[n] = x[xn] mod m for xn <= 2n
+	template<unsigned base>
+	void ModContext<base>::Barrett(const limb_t* x, std::size_t xn, limb_t* out, limb_t* scratch) const
+	{
+		xn = detail::normalized_size(x, xn);
+		if (detail::cmp(x, xn, M(), n) < 0)
+		{
+			std::copy(x, x + xn, out);
+			std::fill(out + xn, out + n, limb_t(0));
+			return;
+		}
+
+		// q3 = floor(floor(x / B^(n-1)) * mu / B^(n+1)) is at most two below x / m
+		const std::size_t q1n = xn - (n - 1), mun = n + 2;
+		limb_t* q2 = scratch;
+		limb_t* r = q2 + q1n + mun;
+		limb_t* qm = r + n + 1;
+		detail::mul(q2, x + n - 1, q1n, mu.data(), mun);
+		const limb_t* q3 = q2 + n + 1;
+		const std::size_t q3n = std::min(q1n + mun - (n + 1), n + 1);
+		detail::mul(qm, q3, q3n, M(), n);
+
+		// r = (x - q3 * m) mod B^(n+1)
+		std::copy(x, x + std::min(xn, n + 1), r);
+		std::fill(r + std::min(xn, n + 1), r + n + 1, limb_t(0));
+		detail::sub_n(r, r, qm, n + 1);
+		while (detail::cmp(r, detail::normalized_size(r, n + 1), M(), n) >= 0)
+			detail::sub(r, r, n + 1, M(), n);
+		std::copy(r, r + n, out);
+	}
+
+	// out[n] = t * R^-1 mod m for t[2n+1] < m * R, t is clobbered
+	template<unsigned base>
+	void ModContext<base>::Redc(limb_t* t, limb_t* out) const
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const limb_t c = detail::addmul_1(t + i, M(), n, t[i] * inv);
+			detail::add_1(t + i + n, t + i + n, n + 1 - i, c);
+		}
+		limb_t* r = t + n;
+		if (detail::cmp(r, detail::normalized_size(r, n + 1), M(), n) >= 0)
+			detail::sub(r, r, n + 1, M(), n);
+		std::copy(r, r + n, out);
+	}
+
+	template<unsigned base>
+	void ModContext<base>::MulReduce(const limb_t* a, const limb_t* b, limb_t* out, limb_t* scratch, bool useMontgomery) const
+	{
+		limb_t* t = scratch;
+		detail::mul(t, a, n, b, n);
+		if (useMontgomery)
+		{
+			t[2 * n] = 0;
+			Redc(t, out);
+		}
+		else
+			Barrett(t, 2 * n, out, scratch + 2 * n + 1);
+	}
+
+	template<unsigned base>
+	void ModContext<base>::ToResidue(const BigInt<base>& x, limb_t* out, limb_t* scratch) const
+	{
+		const std::size_t xn = x.mag.size();
+		if (xn <= 2 * n)
+			Barrett(x.mag.data(), xn, out, scratch);
+		else
+		{
+			// wider than m^2, fall back to a single division
+			const BigInt<base> r = x.Abs() % modulus;
+			std::copy(r.mag.begin(), r.mag.end(), out);
+			std::fill(out + r.mag.size(), out + n, limb_t(0));
+		}
+		if (!x.sign && detail::normalized_size(out, n))
+			detail::sub_n(out, M(), out, n);
+	}
+
+	template<unsigned base>
+	BigInt<base> ModContext<base>::FromResidue(const limb_t* r) const
+	{
+		BigInt<base> result;
+		result.mag.assign(r, r + n);
+		result.Trim();
+		return result;
+	}
+
+	template<unsigned base>
+	BigInt<base> ModContext<base>::Reduce(const BigInt<base>& x) const
+	{
+		detail::scratch_buffer s(n + ScratchSize());
+		ToResidue(x, s.data(), s.data() + n);
+		return FromResidue(s.data());
+	}
+
+	template<unsigned base>
+	void ModContext<base>::Reduce(std::vector<BigInt<base>>& values) const
+	{
+		detail::scratch_buffer s(n + ScratchSize());
+		for (BigInt<base>& x : values)
+		{
+			ToResidue(x, s.data(), s.data() + n);
+			x.mag.assign(s.data(), s.data() + n);
+			x.sign = true;
+			x.Trim();
+		}
+	}
+
+	template<unsigned base>
+	BigInt<base> ModContext<base>::MulMod(const BigInt<base>& lhs, const BigInt<base>& rhs) const
+	{
+		detail::scratch_buffer s(3 * n + ScratchSize());
+		limb_t* a = s.data();
+		limb_t* b = a + n;
+		limb_t* r = b + n;
+		ToResidue(lhs, a, r + n);
+		ToResidue(rhs, b, r + n);
+		MulReduce(a, b, r, r + n, false);
+		return FromResidue(r);
+	}
+
+	template<unsigned base>
+	BigInt<base> ModContext<base>::PowMod(const BigInt<base>& powerBase, const BigInt<base>& exponent) const
+	{
+		if (!exponent.sign) throw std::domain_error("Negative exponent in modular power.");
+
+		// sliding window as in BigInt::Power, on fixed n-limb residues
+		const std::size_t count = std::size_t(1) << (detail::power_window(exponent.BitLength()) - 1);
+		detail::scratch_buffer s((count + 3) * n + ScratchSize());
+		limb_t* odd = s.data();
+		limb_t* result = odd + count * n;
+		limb_t* square = result + n;
+		limb_t* tmp = square + n;
+		limb_t* scratch = tmp + n;
+
+		// enter Montgomery form by multiplying with R^2 * R^-1
+		ToResidue(powerBase, tmp, scratch);
+		if (montgomery)
+			MulReduce(tmp, r2.data(), odd, scratch, true);
+		else
+			std::copy(tmp, tmp + n, odd);
+		std::fill(tmp, tmp + n, limb_t(0));
+		tmp[0] = 1;
+		if (montgomery)
+			MulReduce(r2.data(), tmp, result, scratch, true);
+		else
+			Barrett(tmp, n, result, scratch);
+
+		if (count > 1)
+		{
+			MulReduce(odd, odd, square, scratch, montgomery);
+			for (std::size_t i = 1; i < count; ++i)
+				MulReduce(odd + (i - 1) * n, square, odd + i * n, scratch, montgomery);
+		}
+		detail::sliding_window(exponent.mag.data(), exponent.mag.size(),
+			[&]() { MulReduce(result, result, tmp, scratch, montgomery); std::copy(tmp, tmp + n, result); },
+			[&](std::size_t i) { MulReduce(result, odd + i * n, tmp, scratch, montgomery); std::copy(tmp, tmp + n, result); });
+
+		// leave Montgomery form by multiplying with 1
+		if (montgomery)
+		{
+			std::fill(tmp, tmp + n, limb_t(0));
+			tmp[0] = 1;
+			MulReduce(result, tmp, square, scratch, true);
+			std::copy(square, square + n, result);
+		}
+		return FromResidue(result);
+	}
+
+}
+
+#endif // !MODCONTEXT_H
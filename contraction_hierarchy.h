@@ -0,0 +1,564 @@
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include "graph.h"
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace gasper {
+
+	/**
+	*	Contraction hierarchy for repeated shortest path queries on a static
+	*	graph with non-negative edge costs.
+	*
+	*	Preprocessing contracts the verteces one at a time, lowest priority
+	*	(edge difference plus contracted neighbours, estimated with short witness
+	*	searches) first; the neighbours of a contracted vertex get their priority
+	*	refreshed before their own turn. Contracting v adds
+	*	a shortcut u->w for each pair of its neighbours unless a bounded witness
+	*	search finds a path from u to w around v that is no more expensive. A
+	*	query is then a bidirectional Dijkstra that only climbs to verteces
+	*	contracted later, and the shortcuts on the path it finds are unpacked.
+	*
+	*	Queries reuse the workspaces of the object, so one object serves one
+	*	thread at a time.
+	*/
+	template<typename node_t, typename cost_t>
+	class contraction_hierarchy {
+	public:
+		// settled verteces after which a witness search gives up and keeps the shortcut
+		static const int witness_limit = 500;
+		// edges and settled verteces after which a witness search that only counts shortcuts for a priority gives up
+		static const int estimate_hops = 5, estimate_limit = 20;
+
+		contraction_hierarchy(){};
+		// graph is an array of num_edges graph_edge elements
+		contraction_hierarchy(const graph_edge<node_t, cost_t>* graph, const int num_edges):contraction_hierarchy(csr_graph<node_t, cost_t>(graph, num_edges)){};
+		explicit contraction_hierarchy(const csr_graph<node_t, cost_t>& graph)
+		{
+			contractor builder(graph);
+			builder.contract();
+			build(graph.nodes, builder);
+		}
+
+		int num_verteces() const {return up.num_verteces();}
+		int num_shortcuts() const
+		{
+			int count = 0;
+			for (size_t k = 0; k<up_middle.size(); k++) count += up_middle[k] >= 0;
+			for (size_t k = 0; k<down_middle.size(); k++) count += down_middle[k] >= 0;
+			return count;
+		}
+
+		/**
+		*	Cheapest path from source to target. The path_nodes array is allocated
+		*	with new[], it is NULL with length 0 and cost -1 if target cannot be
+		*	reached.
+		*/
+		path<node_t, cost_t> query(const node_t source, const node_t target)
+		{
+			int meet;
+			const cost_t cost = search(up.index(source), up.index(target), meet);
+			if (meet < 0) return path<node_t, cost_t>(NULL, 0, (cost_t)-1);
+
+			vector<int> verteces;
+			for (int v = meet; v >= 0; v = forward.came_from(v)) verteces.push_back(v);
+			std::reverse(verteces.begin(), verteces.end());
+			for (int v = backward.came_from(meet); v >= 0; v = backward.came_from(v)) verteces.push_back(v);
+
+			vector<node_t> nodes(1, up.nodes[verteces[0]]);
+			for (size_t i = 0; i+1<verteces.size(); i++) unpack(verteces[i], verteces[i+1], nodes);
+			return make_path(nodes, cost);
+		}
+
+		// cost of the cheapest path from source to target, -1 if there is none
+		cost_t distance(const node_t source, const node_t target)
+		{
+			int meet;
+			return search(up.index(source), up.index(target), meet);
+		}
+
+		// writes the hierarchy to filename in the binary layout of this platform
+		void save(const std::string& filename) const
+		{
+			static_assert(std::is_trivially_copyable<node_t>::value && std::is_trivially_copyable<cost_t>::value, "Only hierarchies of trivially copyable nodes and costs can be saved.");
+			std::ofstream file(filename.c_str(), std::ios::binary);
+			if (!file) throw std::runtime_error("Cannot open " + filename + ".");
+			const std::uint32_t header[3] = {file_magic, (std::uint32_t)sizeof(node_t), (std::uint32_t)sizeof(cost_t)};
+			file.write((const char*)header, sizeof(header));
+			write(file, up.nodes);
+			write(file, up.offsets);
+			write(file, up.targets);
+			write(file, up.costs);
+			write(file, up_middle);
+			write(file, down.offsets);
+			write(file, down.targets);
+			write(file, down.costs);
+			write(file, down_middle);
+			if (!file.flush()) throw std::runtime_error("Cannot write " + filename + ".");
+		}
+
+		// replaces the hierarchy by the one saved in filename
+		void load(const std::string& filename)
+		{
+			static_assert(std::is_trivially_copyable<node_t>::value && std::is_trivially_copyable<cost_t>::value, "Only hierarchies of trivially copyable nodes and costs can be loaded.");
+			std::ifstream file(filename.c_str(), std::ios::binary);
+			if (!file) throw std::runtime_error("Cannot open " + filename + ".");
+			std::uint32_t header[3];
+			contraction_hierarchy loaded;
+			if (!file.read((char*)header, sizeof(header)) || header[0] != file_magic || header[1] != sizeof(node_t) || header[2] != sizeof(cost_t)
+				|| !read(file, loaded.up.nodes) || !read(file, loaded.up.offsets) || !read(file, loaded.up.targets) || !read(file, loaded.up.costs) || !read(file, loaded.up_middle)
+				|| !read(file, loaded.down.offsets) || !read(file, loaded.down.targets) || !read(file, loaded.down.costs) || !read(file, loaded.down_middle)
+				|| !loaded.valid())
+				throw std::runtime_error("Invalid contraction hierarchy in " + filename + ".");
+			loaded.down.nodes = loaded.up.nodes;
+			*this = loaded;
+		}
+
+	private:
+		static const std::uint32_t file_magic = 0x31484347;	// "GCH1"
+
+		// up holds the edges to verteces contracted later, down the edges from them turned around
+		csr_graph<node_t, cost_t> up, down;
+		// the vertex each edge of up and down bypasses, -1 for edges of the input graph
+		vector<int> up_middle, down_middle;
+		search_workspace<cost_t> forward, backward;
+
+		struct arc {
+			cost_t cost;
+			int vertex;
+			int middle;
+		};
+
+		// a value for each vertex marked since the last clear, which takes constant time
+		class vertex_marks {
+		public:
+			void clear(const int n)
+			{
+				if ((int)stamp.size() != n)
+				{
+					stamp.assign(n, 0);
+					value.resize(n);
+				}
+				if (++epoch == 0)
+				{
+					std::fill(stamp.begin(), stamp.end(), 0u);
+					epoch = 1;
+				}
+			}
+			bool marked(const int v) const {return stamp[v] == epoch;}
+			int operator[](const int v) const {return value[v];}
+			void mark(const int v, const int x)
+			{
+				stamp[v] = epoch;
+				value[v] = x;
+			}
+
+		private:
+			vector<unsigned> stamp;
+			vector<int> value;
+			unsigned epoch = 0;
+		};
+
+		/**
+		*	Adjacency lists of the graph being contracted, with at most one arc per
+		*	ordered pair. Once v is contracted its lists stay as they are: out[v]
+		*	holds the edges up to verteces contracted later and in[v] those coming
+		*	down from them, while the arcs to v are dropped from the other lists.
+		*/
+		class contractor {
+		public:
+			vector<vector<arc>> out, in;
+
+			explicit contractor(const csr_graph<node_t, cost_t>& graph):out(graph.num_verteces()),in(graph.num_verteces()),contracted(graph.num_verteces(), false),deleted_neighbours(graph.num_verteces(), 0),level(graph.num_verteces(), 0),hops(graph.num_verteces(), 0)
+			{
+				for (int u = 0; u<graph.num_verteces(); u++)
+				{
+					locate(u);
+					for (int k = graph.offsets[u]; k<graph.offsets[u+1]; k++)
+						if (graph.targets[k] != u) add(u, graph.targets[k], graph.costs[k], -1);
+				}
+			}
+
+			void contract()
+			{
+				const int n = (int)out.size();
+				// a vertex whose neighbour was contracted has its priority refreshed before it can be contracted itself
+				vector<bool> dirty(n, false);
+				priority_queue<std::pair<int, int>, vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> order;
+				for (int v = 0; v<n; v++) order.push(std::make_pair(priority(v), v));
+				while (!order.empty())
+				{
+					const int v = order.top().second;
+					order.pop();
+					if (dirty[v])
+					{
+						dirty[v] = false;
+						const int now = priority(v);
+						if (!order.empty() && order.top().first < now)
+						{
+							order.push(std::make_pair(now, v));
+							continue;
+						}
+					}
+					shortcuts(v, true);
+					contracted[v] = true;
+					for (size_t i = 0; i<out[v].size(); i++)
+					{
+						detach(in[out[v][i].vertex], v, out[v][i].vertex);
+						dirty[out[v][i].vertex] = true;
+					}
+					for (size_t i = 0; i<in[v].size(); i++)
+					{
+						detach(out[in[v][i].vertex], v, in[v][i].vertex);
+						dirty[in[v][i].vertex] = true;
+					}
+				}
+			}
+
+		private:
+			vector<bool> contracted;
+			vector<int> deleted_neighbours, level;
+			search_workspace<cost_t> witness;
+			// edges on the witness path to each vertex reached
+			vector<int> hops;
+			// the heads a witness search waits for, and the position of each head in the out list add works on
+			vertex_marks waiting, positions;
+
+			// marks the position of each head of out[u] for the calls to add from u that follow
+			void locate(const int u)
+			{
+				positions.clear((int)out.size());
+				for (size_t i = 0; i<out[u].size(); i++) positions.mark(out[u][i].vertex, (int)i);
+			}
+
+			// adds the arc u->w, or lowers the cost of the one there is; locate(u) comes first
+			void add(const int u, const int w, const cost_t cost, const int middle)
+			{
+				if (positions.marked(w))
+				{
+					arc& existing = out[u][positions[w]];
+					if (!(cost < existing.cost)) return;
+					existing.cost = cost;
+					existing.middle = middle;
+					for (size_t j = 0; j<in[w].size(); j++)
+						if (in[w][j].vertex == u)
+						{
+							in[w][j].cost = cost;
+							in[w][j].middle = middle;
+						}
+					return;
+				}
+				const arc forward_arc = {cost, w, middle}, backward_arc = {cost, u, middle};
+				positions.mark(w, (int)out[u].size());
+				out[u].push_back(forward_arc);
+				in[w].push_back(backward_arc);
+			}
+
+			// drops the arc to the contracted vertex v from the list arcs of its neighbour w
+			void detach(vector<arc>& arcs, const int v, const int w)
+			{
+				for (size_t i = 0; i<arcs.size(); i++)
+					if (arcs[i].vertex == v)
+					{
+						arcs[i] = arcs.back();
+						arcs.pop_back();
+						deleted_neighbours[w]++;
+						level[w] = std::max(level[w], level[v]+1);
+						return;
+					}
+			}
+
+			/**
+			*	Dijkstra from s among the uncontracted verteces other than excluded,
+			*	up to cost limit, max_hops edges and max_settled verteces, that stops
+			*	once the heads of targets are settled.
+			*/
+			void witness_search(const int s, const int excluded, const cost_t limit, const int max_hops, const int max_settled, const vector<arc>& targets)
+			{
+				witness.begin((int)out.size());
+				witness.relax(s, 0, -1);
+				witness.heap.push(s, 0);
+				hops[s] = 0;
+				size_t remaining = targets.size();
+				waiting.clear((int)out.size());
+				for (size_t i = 0; i<targets.size(); i++) waiting.mark(targets[i].vertex, 0);
+				for (int settled = 0; !witness.heap.empty() && settled<max_settled; settled++)
+				{
+					const graph_vertex<int, cost_t> current_vertex = witness.heap.pop();
+					if (limit < current_vertex.cost) break;
+					if (waiting.marked(current_vertex.vertex) && !--remaining) break;
+					if (hops[current_vertex.vertex] >= max_hops) continue;
+					const vector<arc>& arcs = out[current_vertex.vertex];
+					for (size_t i = 0; i<arcs.size(); i++)
+					{
+						if (arcs[i].vertex == excluded) continue;
+						const cost_t cost = current_vertex.cost + arcs[i].cost;
+						if (!(limit < cost) && witness.relax(arcs[i].vertex, cost, current_vertex.vertex))
+						{
+							hops[arcs[i].vertex] = hops[current_vertex.vertex] + 1;
+							witness.heap.push(arcs[i].vertex, cost);
+						}
+					}
+				}
+			}
+
+			// number of shortcuts contracting v needs, added if apply is set and else estimated with cheaper witness searches
+			int shortcuts(const int v, const bool apply)
+			{
+				int count = 0;
+				// add never touches the arc lists of v itself, so they can be walked while it runs
+				for (size_t i = 0; i<in[v].size(); i++)
+				{
+					const arc& from = in[v][i];
+					bool any = false;
+					cost_t limit = 0;
+					for (size_t j = 0; j<out[v].size(); j++)
+						if (out[v][j].vertex != from.vertex && (!any || limit < from.cost + out[v][j].cost))
+						{
+							limit = from.cost + out[v][j].cost;
+							any = true;
+						}
+					if (!any) continue;
+
+					if (apply) witness_search(from.vertex, v, limit, std::numeric_limits<int>::max(), witness_limit, out[v]);
+					else witness_search(from.vertex, v, limit, estimate_hops, estimate_limit, out[v]);
+					if (apply) locate(from.vertex);
+					for (size_t j = 0; j<out[v].size(); j++)
+					{
+						const arc& to = out[v][j];
+						if (to.vertex == from.vertex) continue;
+						const cost_t cost = from.cost + to.cost, witness_cost = witness.distance(to.vertex);
+						if (witness_cost != (cost_t)-1 && !(cost < witness_cost)) continue;
+						count++;
+						if (apply) add(from.vertex, to.vertex, cost, v);
+					}
+				}
+				return count;
+			}
+
+			// twice the edge difference, plus the contracted neighbours and the depth they reach
+			int priority(const int v)
+			{
+				const int removed = (int)(out[v].size() + in[v].size());
+				return 2*(shortcuts(v, false) - removed) + deleted_neighbours[v] + level[v];
+			}
+		};
+
+		// lays the frozen lists of builder out as up and down
+		void build(const vector<node_t>& nodes, const contractor& builder)
+		{
+			const int n = (int)nodes.size();
+			up.nodes = down.nodes = nodes;
+			up.offsets.assign(n+1, 0);
+			down.offsets.assign(n+1, 0);
+			for (int v = 0; v<n; v++)
+			{
+				up.offsets[v+1] = up.offsets[v] + (int)builder.out[v].size();
+				down.offsets[v+1] = down.offsets[v] + (int)builder.in[v].size();
+			}
+			up.targets.resize(up.offsets[n]);
+			up.costs.resize(up.offsets[n]);
+			up_middle.resize(up.offsets[n]);
+			down.targets.resize(down.offsets[n]);
+			down.costs.resize(down.offsets[n]);
+			down_middle.resize(down.offsets[n]);
+			for (int v = 0; v<n; v++)
+			{
+				for (size_t i = 0; i<builder.out[v].size(); i++)
+				{
+					const int k = up.offsets[v] + (int)i;
+					up.targets[k] = builder.out[v][i].vertex;
+					up.costs[k] = builder.out[v][i].cost;
+					up_middle[k] = builder.out[v][i].middle;
+				}
+				for (size_t i = 0; i<builder.in[v].size(); i++)
+				{
+					const int k = down.offsets[v] + (int)i;
+					down.targets[k] = builder.in[v][i].vertex;
+					down.costs[k] = builder.in[v][i].cost;
+					down_middle[k] = builder.in[v][i].middle;
+				}
+			}
+		}
+
+		/**
+		*	Upward bidirectional Dijkstra between the dense indices s and t. The
+		*	cheapest path meets at its highest ranked vertex, so the search stops
+		*	once neither queue can reach below the best meeting cost.
+		*/
+		cost_t search(const int s, const int t, int& meet)
+		{
+			forward.begin(num_verteces());
+			backward.begin(num_verteces());
+			meet = -1;
+			if (s < 0 || t < 0) return (cost_t)-1;
+			forward.relax(s, 0, -1);
+			forward.heap.push(s, 0);
+			backward.relax(t, 0, -1);
+			backward.heap.push(t, 0);
+
+			cost_t best = (cost_t)-1;
+			while (!forward.heap.empty() || !backward.heap.empty())
+			{
+				const bool ahead = !forward.heap.empty() && (backward.heap.empty() || !(backward.heap.top().cost < forward.heap.top().cost));
+				search_workspace<cost_t>& side = ahead ? forward : backward;
+				const search_workspace<cost_t>& other = ahead ? backward : forward;
+				const csr_graph<node_t, cost_t>& edges = ahead ? up : down;
+				if (best != (cost_t)-1 && !(side.heap.top().cost < best)) break;
+
+				const graph_vertex<int, cost_t> current_vertex = side.heap.pop();
+				const int u = current_vertex.vertex;
+				if (other.reached(u) && (best == (cost_t)-1 || current_vertex.cost + other.distance(u) < best))
+				{
+					best = current_vertex.cost + other.distance(u);
+					meet = u;
+				}
+				// stall on demand: u is not on a cheapest path if a higher ranked vertex reaches it for less
+				const csr_graph<node_t, cost_t>& higher = ahead ? down : up;
+				bool stalled = false;
+				for (int k = higher.offsets[u]; k<higher.offsets[u+1] && !stalled; k++)
+					stalled = side.reached(higher.targets[k]) && side.distance(higher.targets[k]) + higher.costs[k] < current_vertex.cost;
+				if (stalled) continue;
+				for (int k = edges.offsets[u]; k<edges.offsets[u+1]; k++)
+				{
+					const cost_t cost = current_vertex.cost + edges.costs[k];
+					if (side.relax(edges.targets[k], cost, u)) side.heap.push(edges.targets[k], cost);
+				}
+			}
+			return best;
+		}
+
+		// the index of the edge a->b, in up at a or else in down at b counting after the edges of up, -1 if there is none
+		int edge(const int a, const int b) const
+		{
+			for (int k = up.offsets[a]; k<up.offsets[a+1]; k++)
+				if (up.targets[k] == b) return k;
+			for (int k = down.offsets[b]; k<down.offsets[b+1]; k++)
+				if (down.targets[k] == a) return (int)up.targets.size() + k;
+			return -1;
+		}
+
+		// the vertex the edge a->b bypasses; the edge is kept in up at a or in down at b, by rank
+		int middle(const int a, const int b) const
+		{
+			const int e = edge(a, b);
+			if (e < 0) return -1;
+			return e < (int)up.targets.size() ? up_middle[e] : down_middle[e - up.targets.size()];
+		}
+
+		// appends the nodes after a on the edge a->b with its shortcuts expanded
+		void unpack(const int a, const int b, vector<node_t>& nodes) const
+		{
+			vector<std::pair<int, int>> pending(1, std::make_pair(a, b));
+			while (!pending.empty())
+			{
+				const std::pair<int, int> edge = pending.back();
+				pending.pop_back();
+				const int m = middle(edge.first, edge.second);
+				if (m < 0)
+				{
+					nodes.push_back(up.nodes[edge.second]);
+					continue;
+				}
+				pending.push_back(std::make_pair(m, edge.second));
+				pending.push_back(std::make_pair(edge.first, m));
+			}
+		}
+
+		/**
+		*	Whether the arrays describe two graphs over the same ascending verteces
+		*	whose shortcuts unpack: every edge a->b with middle m has m apart from
+		*	a and b, the edges a->m and m->b exist, and no edge expands into itself.
+		*/
+		bool valid() const
+		{
+			const int n = (int)up.nodes.size();
+			for (int v = 1; v<n; v++)
+				if (!(up.nodes[v-1] < up.nodes[v])) return false;
+			const csr_graph<node_t, cost_t>* graphs[2] = {&up, &down};
+			const vector<int>* middles[2] = {&up_middle, &down_middle};
+			for (int g = 0; g<2; g++)
+			{
+				const csr_graph<node_t, cost_t>& graph = *graphs[g];
+				if ((int)graph.offsets.size() != n+1 || graph.offsets[0] != 0 || graph.offsets[n] != (int)graph.targets.size()
+					|| graph.costs.size() != graph.targets.size() || middles[g]->size() != graph.targets.size())
+					return false;
+				for (int v = 0; v<n; v++)
+					if (graph.offsets[v+1] < graph.offsets[v]) return false;
+				for (size_t k = 0; k<graph.targets.size(); k++)
+					if (graph.targets[k] < 0 || graph.targets[k] >= n || (*middles[g])[k] < -1 || (*middles[g])[k] >= n) return false;
+			}
+			// the two halves each shortcut unpacks into, -1 for edges of the input graph
+			const int edges = (int)(up.targets.size() + down.targets.size());
+			vector<std::pair<int, int>> halves(edges, std::make_pair(-1, -1));
+			for (int g = 0, e = 0; g<2; g++)
+				for (int v = 0; v<n; v++)
+					for (int k = graphs[g]->offsets[v]; k<graphs[g]->offsets[v+1]; k++, e++)
+					{
+						const int m = (*middles[g])[k];
+						if (m < 0) continue;
+						const int a = g ? graphs[g]->targets[k] : v, b = g ? v : graphs[g]->targets[k];
+						halves[e] = std::make_pair(edge(a, m), edge(m, b));
+						if (m == a || m == b || halves[e].first < 0 || halves[e].second < 0) return false;
+					}
+			// depth first search for an edge that unpacks into itself
+			vector<char> state(edges, 0);	// 0 unseen, 1 being unpacked, 2 unpacks
+			vector<std::pair<int, int>> stack;
+			for (int e = 0; e<edges; e++)
+			{
+				if (state[e]) continue;
+				state[e] = 1;
+				stack.push_back(std::make_pair(e, 0));
+				while (!stack.empty())
+				{
+					std::pair<int, int>& top = stack.back();
+					const int half = top.second++ ? halves[top.first].second : halves[top.first].first;
+					if (top.second > 2 || half < 0)
+					{
+						state[top.first] = 2;
+						stack.pop_back();
+					}
+					else if (state[half] == 1) return false;
+					else if (!state[half])
+					{
+						state[half] = 1;
+						stack.push_back(std::make_pair(half, 0));
+					}
+				}
+			}
+			return true;
+		}
+
+		template<typename T>
+		static void write(std::ofstream& file, const vector<T>& values)
+		{
+			const std::uint64_t size = values.size();
+			file.write((const char*)&size, sizeof(size));
+			if (size) file.write((const char*)values.data(), std::streamsize(size*sizeof(T)));
+		}
+
+		template<typename T>
+		static bool read(std::ifstream& file, vector<T>& values)
+		{
+			std::uint64_t size;
+			if (!file.read((char*)&size, sizeof(size)) || size > (std::uint64_t)std::numeric_limits<int>::max()) return false;
+			// grows values in bounded steps so a corrupt size fails at the end of the file instead of allocating
+			const size_t step = size_t(1) << 16;
+			values.clear();
+			while (values.size() < size)
+			{
+				const size_t done = values.size(), count = std::min(step, (size_t)size - done);
+				values.resize(done + count);
+				if (!file.read((char*)(values.data() + done), std::streamsize(count*sizeof(T)))) return false;
+			}
+			return true;
+		}
+	};
+
+}
+#endif
@@ -3,15 +3,25 @@
 
 #include <queue>
 using std::priority_queue;
+#include <vector>
 using std::vector;
 #include <set>
 using std::set;
 #include <map>
 using std::map;
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace gasper {
 
-	/** 
+	/**
 	*	Dijkstra search algorithm on graphs	with non-negative comparatible edge path cost.
 	*
 	*	node_t is the type of graph verteces
@@ -22,9 +32,9 @@ namespace gasper {
 		node_t begining, end;
 		cost_t cost;
 		graph_edge(){};
-		graph_edge(node_t a, node_t b, node_t c):begining(a),end(b),cost(c){};
+		graph_edge(node_t a, node_t b, cost_t c):begining(a),end(b),cost(c){};
 	};
-	
+
 	template<typename node_t, typename cost_t>
 	struct graph_vertex {
 		node_t vertex;
@@ -32,64 +42,582 @@ namespace gasper {
 		graph_vertex(){};
 		graph_vertex(node_t a, cost_t b):vertex(a),cost(b){};
 	};
-	
+
 	template<typename node_t, typename cost_t>
 	bool operator<(const graph_edge<node_t, cost_t>& left, const graph_edge<node_t, cost_t>& right){return left.cost < right.cost;}
 
 	template<typename node_t, typename cost_t>
 	bool operator<(const graph_vertex<node_t, cost_t>& left, const graph_vertex<node_t, cost_t>& right){return left.cost < right.cost;}
-	
+
 	/**
-	*	graph is an array of graph_edge elements that represent graph edges
-	*	num_edges is the number of edges in graph
-	*	source is the begining vertex for search process
+	*	Node interning: sorts the count keys key(0)..key(count-1), stores the
+	*	distinct ones in nodes and returns the dense index 0..nodes.size()-1 of
+	*	each key, so searches can keep their state in flat arrays.
 	*/
-	template<typename node_t, typename cost_t>
-	graph_vertex<node_t, cost_t>* dijkstra(const graph_edge<node_t, cost_t>* graph, const int num_edges, const node_t source)
+	template<typename node_t, typename key_f>
+	vector<int> intern_nodes(vector<node_t>& nodes, const int count, key_f key)
 	{
-		vector<graph_edge<node_t, cost_t>> graph_edges;
-		priority_queue<graph_vertex<node_t, cost_t>, vector<graph_vertex<node_t, cost_t>>, std::less<vector<graph_vertex<node_t, cost_t>>::value_type>> graph_heap;
-		set<node_t> tmp_verteces;
-		for (int i = 0; i<num_edges; i++) 
-		{
-			graph_edges.insert(graph_edges.end(), *(graph+i));
-			if (tmp_verteces.find(graph_edges[i].begining) == tmp_verteces.end())
-				tmp_verteces.insert(graph_edges[i].begining);
-			if (tmp_verteces.find(graph_edges[i].end) == tmp_verteces.end())
-				tmp_verteces.insert(graph_edges[i].end);
-		}
-		for (set<node_t>::iterator i = tmp_verteces.begin(); i!=tmp_verteces.end(); i++)
-			graph_heap.push(graph_vertex<node_t, cost_t>(*i, (*i != source)?-1:0));
-		
-		vector<graph_vertex<node_t, cost_t>> result;
-		while (!graph_heap.empty())
-		{
-			graph_vertex<node_t, cost_t> current_vertex = graph_heap.top();
-			graph_heap.pop();
-			
+		vector<std::pair<node_t, int>> keys(count);
+		vector<int> ids(count);
+		for (int i = 0; i<count; i++) keys[i] = std::make_pair(key(i), i);
+		std::sort(keys.begin(), keys.end(), [](const std::pair<node_t, int>& a, const std::pair<node_t, int>& b){return a.first < b.first;});
+		nodes.clear();
+		for (int i = 0; i<count; i++)
+		{
+			if (nodes.empty() || nodes.back() < keys[i].first) nodes.push_back(keys[i].first);
+			ids[keys[i].second] = (int)nodes.size()-1;
+		}
+		return ids;
+	}
+
+	/**
+	*	arity-ary min-heap of dense vertex indices 0..n-1 keyed by cost, with
+	*	decrease-key: every vertex is in the heap at most once and push lowers
+	*	the key of a vertex that is already queued.
+	*/
+	template<typename cost_t, int arity = 4>
+	class indexed_heap {
+	public:
+		explicit indexed_heap(const int n = 0):position(n, -1){};
+
+		// empties the heap and makes room for verteces 0..n-1
+		void reset(const int n)
+		{
+			clear();
+			position.assign(n, -1);
+		}
+		// empties the heap in time proportional to its size
+		void clear()
+		{
+			for (size_t i = 0; i<heap.size(); i++) position[heap[i].vertex] = -1;
+			heap.clear();
+		}
+
+		bool empty() const {return heap.empty();}
+		int size() const {return (int)heap.size();}
+		bool contains(const int v) const {return position[v] >= 0;}
+		const graph_vertex<int, cost_t>& top() const {return heap[0];}
+
+		// queues v with key cost, or lowers its key if it is queued already
+		void push(const int v, const cost_t cost)
+		{
+			int i = position[v];
+			if (i < 0)
+			{
+				i = (int)heap.size();
+				heap.push_back(graph_vertex<int, cost_t>(v, cost));
+			}
+			else heap[i].cost = cost;
+			sift_up(i);
+		}
+
+		graph_vertex<int, cost_t> pop()
+		{
+			const graph_vertex<int, cost_t> top = heap[0];
+			position[top.vertex] = -1;
+			const graph_vertex<int, cost_t> last = heap.back();
+			heap.pop_back();
+			if (!heap.empty())
+			{
+				heap[0] = last;
+				position[last.vertex] = 0;
+				sift_down(0);
+			}
+			return top;
+		}
+
+	private:
+		vector<graph_vertex<int, cost_t>> heap;
+		vector<int> position;
+
+		void sift_up(int i)
+		{
+			const graph_vertex<int, cost_t> item = heap[i];
+			while (i > 0)
+			{
+				const int parent = (i-1)/arity;
+				if (!(item.cost < heap[parent].cost)) break;
+				place(i, heap[parent]);
+				i = parent;
+			}
+			place(i, item);
+		}
+
+		void sift_down(int i)
+		{
+			const graph_vertex<int, cost_t> item = heap[i];
+			const int n = (int)heap.size();
+			for (;;)
+			{
+				const int first = i*arity+1;
+				if (first >= n) break;
+				int best = first;
+				for (int c = first+1; c<first+arity && c<n; c++)
+					if (heap[c].cost < heap[best].cost) best = c;
+				if (!(heap[best].cost < item.cost)) break;
+				place(i, heap[best]);
+				i = best;
+			}
+			place(i, item);
+		}
+
+		void place(const int i, const graph_vertex<int, cost_t>& item)
+		{
+			heap[i] = item;
+			position[item.vertex] = i;
+		}
+	};
+
+	/**
+	*	Search state over dense vertex indices: tentative costs, parents and the
+	*	heap. A vertex counts as unreached unless its stamp matches the current
+	*	epoch, so a new search starts in O(1) instead of clearing the arrays.
+	*/
+	template<typename cost_t>
+	class search_workspace {
+	public:
+		indexed_heap<cost_t> heap;
+
+		// starts a new search over verteces 0..n-1
+		void begin(const int n)
+		{
+			if ((int)stamp.size() != n)
+			{
+				heap.reset(n);
+				cost.resize(n);
+				parent.resize(n);
+				stamp.assign(n, 0);
+				epoch = 0;
+			}
+			else heap.clear();
+			if (++epoch == 0)
+			{
+				std::fill(stamp.begin(), stamp.end(), 0u);
+				epoch = 1;
+			}
+		}
+
+		bool reached(const int v) const {return stamp[v] == epoch;}
+		// cost of v found so far, -1 if it is unreached
+		cost_t distance(const int v) const {return reached(v) ? cost[v] : (cost_t)-1;}
+		// predecessor of v, -1 for seeds and unreached verteces
+		int came_from(const int v) const {return reached(v) ? parent[v] : -1;}
+
+		// records c as the cost of v via from if v is unreached or c improves on it
+		bool relax(const int v, const cost_t c, const int from)
+		{
+			if (reached(v) && !(c < cost[v])) return false;
+			stamp[v] = epoch;
+			cost[v] = c;
+			parent[v] = from;
+			return true;
+		}
+
+	private:
+		vector<cost_t> cost;
+		vector<int> parent;
+		vector<unsigned> stamp;
+		unsigned epoch = 0;
+	};
+
+	/**
+	*	Compressed sparse row adjacency, built once and reused by every search.
+	*
+	*	Verteces are numbered 0..num_verteces()-1 in ascending node_t order,
+	*	nodes[i] is the vertex with index i. The outgoing edges of vertex i are
+	*	targets[k], costs[k] for k in [offsets[i], offsets[i+1]), so a search
+	*	touches only the edges of the verteces it expands.
+	*/
+	template<typename node_t, typename cost_t>
+	struct csr_graph {
+		vector<node_t> nodes;
+		vector<int> offsets, targets;
+		vector<cost_t> costs;
+
+		csr_graph():offsets(1, 0){};
+
+		// graph is an array of num_edges graph_edge elements
+		csr_graph(const graph_edge<node_t, cost_t>* graph, const int num_edges)
+		{
+			// endpoint 2i is the begining and 2i+1 the end of edge i
+			const vector<int> ids = intern_nodes(nodes, 2*num_edges, [graph](int i){return (i&1) ? graph[i>>1].end : graph[i>>1].begining;});
+			build(num_edges, [&](int i){return ids[2*i];}, [&](int i){return ids[2*i+1];}, [graph](int i){return graph[i].cost;});
+		}
+
+		// graph is the distance matrix, positive entries are edges
+		csr_graph(cost_t** graph, const node_t* verteces, const int num_verteces)
+		{
+			from_matrix(verteces, num_verteces, [&](int i, int j){return graph[i][j];});
+		}
+
+		// graph is the distance matrix as a one dimensional array, positive entries are edges
+		csr_graph(const cost_t* graph, const node_t* verteces, const int num_verteces)
+		{
+			from_matrix(verteces, num_verteces, [&](int i, int j){return graph[i*num_verteces+j];});
+		}
+
+		int num_verteces() const {return (int)nodes.size();}
+		int num_edges() const {return (int)targets.size();}
+
+		// index of node, -1 if it is not a vertex of the graph
+		int index(const node_t& node) const
+		{
+			typename vector<node_t>::const_iterator i = std::lower_bound(nodes.begin(), nodes.end(), node);
+			return (i == nodes.end() || node < *i) ? -1 : (int)(i - nodes.begin());
+		}
+
+		// the graph with every edge turned around, verteces keep their indices
+		csr_graph reversed() const
+		{
+			csr_graph reverse;
+			reverse.nodes = nodes;
+			vector<int> from(targets.size());
+			for (int v = 0; v<num_verteces(); v++)
+				for (int k = offsets[v]; k<offsets[v+1]; k++) from[k] = v;
+			reverse.build(num_edges(), [&](int i){return targets[i];}, [&](int i){return from[i];}, [&](int i){return costs[i];});
+			return reverse;
+		}
+
+	private:
+		// counting sort of the edges by source index
+		template<typename from_f, typename to_f, typename cost_f>
+		void build(const int num_edges, from_f from, to_f to, cost_f cost)
+		{
+			offsets.assign(nodes.size()+1, 0);
+			for (int i = 0; i<num_edges; i++) offsets[from(i)+1]++;
+			for (size_t v = 0; v<nodes.size(); v++) offsets[v+1] += offsets[v];
+			targets.resize(num_edges);
+			costs.resize(num_edges);
+			vector<int> next(offsets.begin(), offsets.end()-1);
 			for (int i = 0; i<num_edges; i++)
 			{
-				if (current_vertex.cost == -1) continue;
-				if (graph_edges[i].begining == current_vertex.vertex)
-					graph_heap.push(graph_vertex<node_t, cost_t>(graph_edges[i].end, current_vertex.cost+graph_edges[i].cost));
+				const int k = next[from(i)]++;
+				targets[k] = to(i);
+				costs[k] = cost(i);
+			}
+		}
+
+		template<typename entry_f>
+		void from_matrix(const node_t* verteces, const int num_verteces, entry_f entry)
+		{
+			const vector<int> rank = intern_nodes(nodes, num_verteces, [verteces](int i){return verteces[i];});
+
+			vector<int> from, to;
+			vector<cost_t> cost;
+			for (int i = 0; i<num_verteces; i++)
+				for (int j = 0; j<num_verteces; j++)
+					if (entry(i, j)>0)
+					{
+						from.push_back(rank[i]);
+						to.push_back(rank[j]);
+						cost.push_back(entry(i, j));
+					}
+			build((int)from.size(), [&](int i){return from[i];}, [&](int i){return to[i];}, [&](int i){return cost[i];});
+		}
+	};
+
+	/**
+	*	Fixed set of threads that share out the items of one batch at a time.
+	*	The thread calling run works along, so a pool of one thread runs inline.
+	*/
+	class search_pool {
+	public:
+		explicit search_pool(unsigned threads = 0)
+		{
+			if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+			count = threads;
+			for (unsigned w = 1; w<threads; w++) workers.emplace_back([this, w]{work(w);});
+		}
+		~search_pool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				closing = true;
+			}
+			wake.notify_all();
+			for (size_t i = 0; i<workers.size(); i++) workers[i].join();
+		}
+		search_pool(const search_pool&) = delete;
+		search_pool& operator=(const search_pool&) = delete;
+
+		unsigned threads() const {return count;}
+
+		// calls job(worker, i) for every i in [0, items), worker is 0..threads()-1 and unique to the running thread
+		void run(const size_t items, const std::function<void(unsigned, size_t)>& job)
+		{
+			if (!items) return;
+			std::lock_guard<std::mutex> batch(batch_lock);
+			if (items == 1 || count == 1)
+			{
+				for (size_t i = 0; i<items; i++) job(0, i);
+				return;
 			}
-			
-			bool flag = false;
-			for (int i = 0; i<result.size(); i++)
-				if (current_vertex.vertex == result[i].vertex)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				current = &job;
+				total = items;
+				next = 0;
+				error = nullptr;
+				busy = count-1;
+				generation++;
+			}
+			wake.notify_all();
+			drain(0);
+
+			std::unique_lock<std::mutex> guard(lock);
+			done.wait(guard, [this]{return busy == 0;});
+			current = NULL;
+			if (error) std::rethrow_exception(error);
+		}
+
+	private:
+		unsigned count;
+		vector<std::thread> workers;
+		std::mutex lock, batch_lock;
+		std::condition_variable wake, done;
+		const std::function<void(unsigned, size_t)>* current = NULL;
+		std::atomic<size_t> next{0};
+		size_t total = 0;
+		unsigned busy = 0, generation = 0;
+		bool closing = false;
+		std::exception_ptr error;
+
+		void drain(const unsigned worker)
+		{
+			for (size_t i; (i = next.fetch_add(1)) < total;)
+				try {(*current)(worker, i);}
+				catch (...)
 				{
-					result[i].cost = (current_vertex.cost < result[i].cost && current_vertex.cost != -1) ? current_vertex.cost : result[i].cost;
-					flag = true;
+					std::lock_guard<std::mutex> guard(lock);
+					if (!error) error = std::current_exception();
+					next = total;
 				}
-			if (!flag) result.insert(result.end(), current_vertex);
 		}
-		
-		graph_vertex<node_t, cost_t>* result_array = new graph_vertex<node_t, cost_t>[result.size()];
-		for (int i = 0; i<result.size(); i++)
-			result_array[i] = result[i];
+
+		void work(const unsigned worker)
+		{
+			for (unsigned seen = 0;;)
+			{
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					wake.wait(guard, [&]{return closing || generation != seen;});
+					if (closing) return;
+					seen = generation;
+				}
+				drain(worker);
+				std::lock_guard<std::mutex> guard(lock);
+				if (--busy == 0) done.notify_one();
+			}
+		}
+	};
+
+	// whether cost is within bound, -1 standing for no bound
+	template<typename cost_t>
+	bool within_bound(const cost_t cost, const cost_t bound)
+	{
+		return bound == (cost_t)-1 || !(bound < cost);
+	}
+
+	/**
+	*	Dijkstra search from seeds[0..num_seeds), each seed starting at its own
+	*	cost. Verteces costing more than bound are left unreached, and the search
+	*	stops early once settle(v, cost), called as each vertex is settled,
+	*	returns false. The costs and parents are left in workspace.
+	*/
+	template<typename node_t, typename cost_t, typename settle_f>
+	void dijkstra_search(const csr_graph<node_t, cost_t>& graph, search_workspace<cost_t>& workspace, const graph_vertex<node_t, cost_t>* seeds, const int num_seeds, const cost_t bound, settle_f settle)
+	{
+		workspace.begin(graph.num_verteces());
+		for (int i = 0; i<num_seeds; i++)
+		{
+			const int s = graph.index(seeds[i].vertex);
+			if (s >= 0 && within_bound(seeds[i].cost, bound) && workspace.relax(s, seeds[i].cost, -1)) workspace.heap.push(s, seeds[i].cost);
+		}
+		while (!workspace.heap.empty())
+		{
+			const graph_vertex<int, cost_t> current_vertex = workspace.heap.pop();
+			if (!settle(current_vertex.vertex, current_vertex.cost)) break;
+			for (int k = graph.offsets[current_vertex.vertex]; k<graph.offsets[current_vertex.vertex+1]; k++)
+			{
+				// settled verteces never improve, so they are not queued again
+				const int v = graph.targets[k];
+				const cost_t cost = current_vertex.cost + graph.costs[k];
+				if (within_bound(cost, bound) && workspace.relax(v, cost, current_vertex.vertex)) workspace.heap.push(v, cost);
+			}
+		}
+	}
+
+	template<typename node_t, typename cost_t>
+	void dijkstra_search(const csr_graph<node_t, cost_t>& graph, search_workspace<cost_t>& workspace, const graph_vertex<node_t, cost_t>* seeds, const int num_seeds)
+	{
+		dijkstra_search(graph, workspace, seeds, num_seeds, (cost_t)-1, [](int, cost_t){return true;});
+	}
+
+	// the nodes on the way to v found by the last search in workspace, seed first
+	template<typename node_t, typename cost_t>
+	vector<node_t> trace_path(const csr_graph<node_t, cost_t>& graph, const search_workspace<cost_t>& workspace, const int v)
+	{
+		vector<node_t> nodes;
+		for (int u = v; u >= 0; u = workspace.came_from(u)) nodes.push_back(graph.nodes[u]);
+		std::reverse(nodes.begin(), nodes.end());
+		return nodes;
+	}
+
+	/**
+	*	Shortest path costs from source to every vertex of graph, as an array of
+	*	graph.num_verteces() elements in ascending vertex order. Unreachable
+	*	verteces have cost -1. The array is allocated with new[].
+	*/
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* dijkstra(const csr_graph<node_t, cost_t>& graph, const node_t source)
+	{
+		search_workspace<cost_t> workspace;
+		const graph_vertex<node_t, cost_t> seed(source, 0);
+		dijkstra_search(graph, workspace, &seed, 1);
+
+		const int n = graph.num_verteces();
+		graph_vertex<node_t, cost_t>* result_array = new graph_vertex<node_t, cost_t>[n];
+		for (int i = 0; i<n; i++)
+			result_array[i] = graph_vertex<node_t, cost_t>(graph.nodes[i], workspace.distance(i));
 		return result_array;
 	}
-	
+
+	/**
+	*	Parallel single source shortest paths by delta-stepping, with the result
+	*	shaped like dijkstra's. Verteces wait in buckets of width delta; a bucket
+	*	is settled in rounds that relax the light edges (cost <= delta) of its
+	*	verteces across the threads of pool, then their heavy edges once. delta 0
+	*	picks the largest edge cost over the average degree. cost_t must be an
+	*	arithmetic type.
+	*/
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* delta_stepping(const csr_graph<node_t, cost_t>& graph, const node_t source, search_pool& pool, cost_t delta = 0)
+	{
+		const int n = graph.num_verteces(), m = graph.num_edges();
+		cost_t max_cost = 0;
+		for (int k = 0; k<m; k++)
+			if (max_cost < graph.costs[k]) max_cost = graph.costs[k];
+		if (!(delta > 0) && n) delta = max_cost / (cost_t)std::max(1, m/n);
+		if (!(delta > 0)) delta = 1;
+		// live costs span fewer than max_cost / delta + 2 buckets, which are reused cyclically
+		const size_t max_buckets = size_t(1) << 20;
+		if (!(max_cost / delta < (cost_t)max_buckets)) delta = max_cost / (cost_t)(max_buckets/2);
+		const size_t num_buckets = size_t(max_cost / delta) + 3;
+		auto bucket = [delta](const cost_t cost){return size_t(cost / delta);};
+
+		vector<std::atomic<cost_t>> distance(n);
+		for (int v = 0; v<n; v++) distance[v].store((cost_t)-1, std::memory_order_relaxed);
+		vector<vector<int>> buckets(num_buckets);
+		vector<unsigned> taken(n, 0);
+		vector<vector<int>> improved(pool.threads());
+		size_t pending = 0;
+
+		// relaxes the light or the heavy edges of from, then files the improved verteces into their buckets
+		auto expand = [&](const vector<graph_vertex<int, cost_t>>& from, const bool light)
+		{
+			const size_t chunk = 256;
+			pool.run((from.size()+chunk-1)/chunk, [&](unsigned worker, size_t c)
+			{
+				for (size_t i = c*chunk; i<from.size() && i<(c+1)*chunk; i++)
+				{
+					const int u = from[i].vertex;
+					if (!light && distance[u].load(std::memory_order_relaxed) < from[i].cost) continue;
+					for (int k = graph.offsets[u]; k<graph.offsets[u+1]; k++)
+					{
+						if (delta < graph.costs[k] ? light : !light) continue;
+						const int v = graph.targets[k];
+						const cost_t cost = from[i].cost + graph.costs[k];
+						cost_t current = distance[v].load(std::memory_order_relaxed);
+						while (current == (cost_t)-1 || cost < current)
+							if (distance[v].compare_exchange_weak(current, cost, std::memory_order_relaxed))
+							{
+								improved[worker].push_back(v);
+								break;
+							}
+					}
+				}
+			});
+			for (size_t w = 0; w<improved.size(); w++)
+			{
+				for (size_t i = 0; i<improved[w].size(); i++)
+					buckets[bucket(distance[improved[w][i]].load(std::memory_order_relaxed)) % num_buckets].push_back(improved[w][i]);
+				pending += improved[w].size();
+				improved[w].clear();
+			}
+		};
+
+		const int s = graph.index(source);
+		if (s >= 0)
+		{
+			distance[s].store(0, std::memory_order_relaxed);
+			buckets[0].push_back(s);
+			pending = 1;
+		}
+		vector<graph_vertex<int, cost_t>> frontier, settled;
+		unsigned round = 0;
+		for (size_t i = 0; pending; i++)
+		{
+			vector<int>& slot = buckets[i % num_buckets];
+			settled.clear();
+			while (!slot.empty())
+			{
+				// entries whose vertex has moved to a lower bucket or is already taken are stale
+				round++;
+				frontier.clear();
+				pending -= slot.size();
+				for (size_t j = 0; j<slot.size(); j++)
+				{
+					const int v = slot[j];
+					const cost_t cost = distance[v].load(std::memory_order_relaxed);
+					if (bucket(cost) != i || taken[v] == round) continue;
+					taken[v] = round;
+					frontier.push_back(graph_vertex<int, cost_t>(v, cost));
+				}
+				slot.clear();
+				settled.insert(settled.end(), frontier.begin(), frontier.end());
+				expand(frontier, true);
+			}
+			expand(settled, false);
+		}
+
+		graph_vertex<node_t, cost_t>* result_array = new graph_vertex<node_t, cost_t>[n];
+		for (int i = 0; i<n; i++)
+			result_array[i] = graph_vertex<node_t, cost_t>(graph.nodes[i], distance[i].load(std::memory_order_relaxed));
+		return result_array;
+	}
+
+	// delta_stepping on a pool of its own with threads, 0 for one per core
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* delta_stepping(const csr_graph<node_t, cost_t>& graph, const node_t source, cost_t delta = 0, const unsigned threads = 0)
+	{
+		search_pool pool(threads);
+		return delta_stepping(graph, source, pool, delta);
+	}
+
+	// dijkstra, or delta_stepping with the default delta on threads when parallel is set
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* dijkstra(const csr_graph<node_t, cost_t>& graph, const node_t source, const bool parallel, const unsigned threads = 0)
+	{
+		return parallel ? delta_stepping(graph, source, (cost_t)0, threads) : dijkstra(graph, source);
+	}
+	// the same on the caller's pool, so repeated searches do not start threads each time
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* dijkstra(const csr_graph<node_t, cost_t>& graph, const node_t source, const bool parallel, search_pool& pool)
+	{
+		return parallel ? delta_stepping(graph, source, pool, (cost_t)0) : dijkstra(graph, source);
+	}
+
+	/**
+	*	graph is an array of graph_edge elements that represent graph edges
+	*	num_edges is the number of edges in graph
+	*	source is the begining vertex for search process
+	*/
+	template<typename node_t, typename cost_t>
+	graph_vertex<node_t, cost_t>* dijkstra(const graph_edge<node_t, cost_t>* graph, const int num_edges, const node_t source)
+	{
+		return dijkstra(csr_graph<node_t, cost_t>(graph, num_edges), source);
+	}
+
 	/*
 	*	graph is the distance matrix
 	*	verteces is the array of verteces as they represented in graph
@@ -99,19 +627,9 @@ namespace gasper {
 	template<typename node_t, typename cost_t>
 	graph_vertex<node_t, cost_t>* dijkstra(cost_t** graph, const node_t* verteces, const int num_verteces, const node_t source)
 	{
-		int num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i][j]>0) num_edges++;
-		graph_edge<node_t, cost_t>* graph_edges = new graph_edge<node_t, cost_t>[num_edges];
-		num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i][j]>0) 
-					graph_edges[num_edges++] = graph_edge<node_t, cost_t>(verteces[i], verteces[j], graph[i][j]);
-		return dijkstra<node_t, cost_t>(graph_edges, num_edges, source);
-	}
-	
+		return dijkstra(csr_graph<node_t, cost_t>(graph, verteces, num_verteces), source);
+	}
+
 	/*
 	*	graph is the distance matrix as a one dimensional array
 	*	verteces is the array of verteces as they represented in graph
@@ -121,19 +639,10 @@ namespace gasper {
 	template<typename node_t, typename cost_t>
 	graph_vertex<node_t, cost_t>* dijkstra(cost_t* graph, const node_t* verteces, const int num_verteces, const node_t source)
 	{
-		int num_edges = 0;
-		for (int i = 0; i<num_verteces*num_verteces; i++)
-			if (graph[i]>0) num_edges++;
-		graph_edge<node_t, cost_t>* graph_edges = new graph_edge<node_t, cost_t>[num_edges];
-		num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i*num_verteces+j]>0) 
-					graph_edges[num_edges++] = graph_edge<node_t, cost_t>(verteces[i], verteces[j], graph[i*num_verteces+j]);
-		return dijkstra<node_t, cost_t>(graph_edges, num_edges, source);
+		return dijkstra(csr_graph<node_t, cost_t>((const cost_t*)graph, verteces, num_verteces), source);
 	}
 
-	/** 
+	/**
 	*	A* pathfinding algorithm on graphs
 	*/
 
@@ -159,90 +668,395 @@ namespace gasper {
 		return p;
 	}
 
+	/**
+	*	A* search from seeds[0..num_seeds) to end, that stops as soon as end is
+	*	expanded; heuristic must never overestimate the remaining cost. Paths
+	*	that cannot stay within bound are not followed. The costs and parents
+	*	are left in workspace.
+	*/
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
+	void A_star_search(const csr_graph<node_t, cost_t>& graph, search_workspace<cost_t>& workspace, const graph_vertex<node_t, cost_t>* seeds, const int num_seeds, const node_t end, const cost_t bound = (cost_t)-1)
+	{
+		workspace.begin(graph.num_verteces());
+		const int t = graph.index(end);
+		if (t < 0) return;
+		for (int i = 0; i<num_seeds; i++)
+		{
+			const int s = graph.index(seeds[i].vertex);
+			const cost_t f_score = seeds[i].cost + heuristic(seeds[i].vertex, end);
+			if (s >= 0 && within_bound(f_score, bound) && workspace.relax(s, seeds[i].cost, -1)) workspace.heap.push(s, f_score);
+		}
+		while (!workspace.heap.empty())
+		{
+			const int u = workspace.heap.pop().vertex;
+			if (u == t) break;
+
+			const cost_t g_score = workspace.distance(u);
+			for (int k = graph.offsets[u]; k<graph.offsets[u+1]; k++)
+			{
+				// an expanded vertex is queued again if it improves
+				const int v = graph.targets[k];
+				const cost_t tent_g_score = g_score + graph.costs[k];
+				const cost_t f_score = tent_g_score + heuristic(graph.nodes[v], end);
+				if (within_bound(f_score, bound) && workspace.relax(v, tent_g_score, u)) workspace.heap.push(v, f_score);
+			}
+		}
+	}
+
+	// a path holding a new[] copy of nodes, NULL with length 0 and cost -1 if there are none
+	template<typename node_t, typename cost_t>
+	path<node_t, cost_t> make_path(const vector<node_t>& nodes, const cost_t cost)
+	{
+		if (nodes.empty()) return path<node_t, cost_t>(NULL, 0, (cost_t)-1);
+		node_t* result_array = new node_t[nodes.size()];
+		std::copy(nodes.begin(), nodes.end(), result_array);
+		return path<node_t, cost_t>(result_array, (int)nodes.size(), cost);
+	}
+
+	/**
+	*	Cheapest path from begining to end; heuristic must never overestimate
+	*	the remaining cost. The path_nodes array is allocated with new[], it is
+	*	NULL with length 0 and cost -1 if end cannot be reached within bound.
+	*/
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
+	path<node_t, cost_t> A_star(const csr_graph<node_t, cost_t>& graph, const node_t begining, const node_t end, const cost_t bound = (cost_t)-1)
+	{
+		search_workspace<cost_t> workspace;
+		const graph_vertex<node_t, cost_t> seed(begining, 0);
+		A_star_search<node_t, cost_t, heuristic>(graph, workspace, &seed, 1, end, bound);
+
+		const int t = graph.index(end);
+		if (t < 0 || !workspace.reached(t))
+			return path<node_t, cost_t>(NULL, 0, (cost_t)-1);
+		return make_path(trace_path(graph, workspace, t), workspace.distance(t));
+	}
+
 	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
 	path<node_t, cost_t> A_star(const graph_edge<node_t, cost_t>* graph, const int num_edges, const node_t begining, const node_t end)
 	{
-		vector<graph_edge<node_t, cost_t>> graph_edges;
-		set<node_t> closed_set, open_set;
-		map<node_t, node_t> path;
-		map<node_t, cost_t> g_score;
-		priority_queue<graph_vertex<node_t, cost_t>, vector<graph_vertex<node_t, cost_t>>, std::less<vector<graph_vertex<node_t, cost_t>>::value_type>> f_score;
-		vector<node_t> result;
+		return A_star<node_t, cost_t, heuristic>(csr_graph<node_t, cost_t>(graph, num_edges), begining, end);
+	}
 
-		for (int i = 0; i<num_edges; i++)
-			graph_edges.insert(graph_edges.end(), *(graph+i));
-		open_set.insert(begining);
-		g_score[begining] = 0;
-		f_score.push(graph_vertex<node_t, cost_t>(begining, heuristic(begining, end)));
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
+	path<node_t, cost_t> A_star(cost_t** graph, const node_t* verteces, const int num_verteces, const node_t begining, const node_t end)
+	{
+		return A_star<node_t, cost_t, heuristic>(csr_graph<node_t, cost_t>(graph, verteces, num_verteces), begining, end);
+	}
 
-		while (!open_set.empty())
-		{
-			node_t current_vertex = f_score.top().vertex;
-			if (current_vertex == end)
-				result = reconstruct_path<node_t, cost_t>(path, end);
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
+	path<node_t, cost_t> A_star(const cost_t* graph, const node_t* verteces, const int num_verteces, const node_t begining, const node_t end)
+	{
+		return A_star<node_t, cost_t, heuristic>(csr_graph<node_t, cost_t>(graph, verteces, num_verteces), begining, end);
+	}
 
-			f_score.pop();
-			open_set.erase(current_vertex);
-			closed_set.insert(current_vertex);
+	/**
+	*	Point-to-point searches. They stop as soon as the answer is known and
+	*	leave every vertex costing more than bound (-1 for none) unexplored.
+	*	The bidirectional ones grow a search from source on graph and one from
+	*	target on reverse = graph.reversed(), advancing the side with the
+	*	smaller queue, until no path through the unsettled verteces can beat
+	*	the best meeting found.
+	*/
 
-			for (int i = 0; i<num_edges; i++)
-				if (graph_edges[i].begining == current_vertex)
+	/**
+	*	Core of the bidirectional searches on dense indices s and t. The queues
+	*	are ordered by forward_key(v, g) and backward_key(v, g), which are scale
+	*	times g shifted by consistent potentials. Returns the cost of the best
+	*	path, -1 if there is none within bound, and leaves its verteces in nodes.
+	*/
+	template<typename node_t, typename cost_t, typename forward_key_f, typename backward_key_f>
+	cost_t bidirectional_search(const csr_graph<node_t, cost_t>& graph, const csr_graph<node_t, cost_t>& reverse, search_workspace<cost_t>& forward, search_workspace<cost_t>& backward,
+		const int s, const int t, const cost_t bound, const cost_t scale, forward_key_f forward_key, backward_key_f backward_key, vector<node_t>& nodes)
+	{
+		nodes.clear();
+		forward.begin(graph.num_verteces());
+		backward.begin(graph.num_verteces());
+		if (s < 0 || t < 0) return (cost_t)-1;
+		forward.relax(s, 0, -1);
+		forward.heap.push(s, forward_key(s, 0));
+		backward.relax(t, 0, -1);
+		backward.heap.push(t, backward_key(t, 0));
+
+		cost_t best = (cost_t)-1;
+		int meet = -1;
+		if (s == t)
+		{
+			best = 0;
+			meet = s;
+		}
+		while (meet != s && !forward.heap.empty() && !backward.heap.empty())
+		{
+			// the keys at the tops bound every path through unsettled verteces from below
+			const cost_t lower = forward.heap.top().cost + backward.heap.top().cost;
+			if (best != (cost_t)-1 && !(lower < scale*best)) break;
+			if (bound != (cost_t)-1 && scale*bound < lower) break;
+
+			const bool ahead = forward.heap.size() <= backward.heap.size();
+			search_workspace<cost_t>& side = ahead ? forward : backward;
+			const search_workspace<cost_t>& other = ahead ? backward : forward;
+			const csr_graph<node_t, cost_t>& edges = ahead ? graph : reverse;
+			const int u = side.heap.pop().vertex;
+			const cost_t g_score = side.distance(u);
+			for (int k = edges.offsets[u]; k<edges.offsets[u+1]; k++)
+			{
+				const int v = edges.targets[k];
+				const cost_t cost = g_score + edges.costs[k];
+				if (other.reached(v) && (best == (cost_t)-1 || cost + other.distance(v) < best))
 				{
-					cost_t tent_g_score = g_score[current_vertex] + graph_edges[i].cost;
-					node_t adjacent_vertex = graph_edges[i].end; 
-					if (closed_set.find(adjacent_vertex) != closed_set.end() && tent_g_score >= g_score[adjacent_vertex]) continue;
-					if (open_set.find(adjacent_vertex) == open_set.end() || tent_g_score < g_score[adjacent_vertex])
-					{
-						path[adjacent_vertex] = current_vertex;
-						g_score[adjacent_vertex] = tent_g_score;
-						f_score.push(graph_vertex<node_t, cost_t>(adjacent_vertex, tent_g_score + heuristic(adjacent_vertex, end)));
-						open_set.insert(adjacent_vertex);
-					}
+					best = cost + other.distance(v);
+					meet = v;
 				}
+				if (side.relax(v, cost, u)) side.heap.push(v, ahead ? forward_key(v, cost) : backward_key(v, cost));
+			}
 		}
 
-		node_t* result_array;
-		if (result.size() == 0) 
-			result_array = NULL; 
-		else
+		if (meet < 0 || !within_bound(best, bound)) return (cost_t)-1;
+		nodes = trace_path(graph, forward, meet);
+		for (int v = backward.came_from(meet); v >= 0; v = backward.came_from(v)) nodes.push_back(graph.nodes[v]);
+		return best;
+	}
+
+	template<typename node_t, typename cost_t>
+	cost_t bidirectional_dijkstra_search(const csr_graph<node_t, cost_t>& graph, const csr_graph<node_t, cost_t>& reverse, search_workspace<cost_t>& forward, search_workspace<cost_t>& backward,
+		const node_t source, const node_t target, const cost_t bound, vector<node_t>& nodes)
+	{
+		auto key = [](int, cost_t g){return g;};
+		return bidirectional_search(graph, reverse, forward, backward, graph.index(source), graph.index(target), bound, (cost_t)1, key, key, nodes);
+	}
+
+	/**
+	*	Bidirectional A* with average potentials (heuristic(v, target) -
+	*	heuristic(source, v)) / 2, kept doubled so integer costs stay exact.
+	*	heuristic must be consistent both as an estimate to target and as one
+	*	from source.
+	*/
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
+	cost_t bidirectional_A_star_search(const csr_graph<node_t, cost_t>& graph, const csr_graph<node_t, cost_t>& reverse, search_workspace<cost_t>& forward, search_workspace<cost_t>& backward,
+		const node_t source, const node_t target, const cost_t bound, vector<node_t>& nodes)
+	{
+		// heuristic(source, v) <= g for a forward cost g, so the keys are never negative
+		auto forward_key = [&](int v, cost_t g){return g + g + heuristic(graph.nodes[v], target) - heuristic(source, graph.nodes[v]);};
+		auto backward_key = [&](int v, cost_t g){return g + g + heuristic(source, graph.nodes[v]) - heuristic(graph.nodes[v], target);};
+		return bidirectional_search(graph, reverse, forward, backward, graph.index(source), graph.index(target), bound, (cost_t)2, forward_key, backward_key, nodes);
+	}
+
+	/**
+	*	The k targets closest to the seeds that lie within bound, cheapest
+	*	first. targets holds dense indices in ascending order.
+	*/
+	template<typename node_t, typename cost_t>
+	vector<graph_vertex<node_t, cost_t>> nearest_search(const csr_graph<node_t, cost_t>& graph, search_workspace<cost_t>& workspace, const graph_vertex<node_t, cost_t>* seeds, const int num_seeds,
+		const vector<int>& targets, const size_t k, const cost_t bound)
+	{
+		vector<graph_vertex<node_t, cost_t>> nearest;
+		if (!k || targets.empty()) return nearest;
+		dijkstra_search(graph, workspace, seeds, num_seeds, bound, [&](int v, cost_t cost)
+		{
+			if (std::binary_search(targets.begin(), targets.end(), v)) nearest.push_back(graph_vertex<node_t, cost_t>(graph.nodes[v], cost));
+			return nearest.size() < std::min(k, targets.size());
+		});
+		return nearest;
+	}
+
+	// dense indices of the targets that are verteces of graph, ascending and without repeats
+	template<typename node_t, typename cost_t>
+	vector<int> target_indices(const csr_graph<node_t, cost_t>& graph, const node_t* targets, const int num_targets)
+	{
+		vector<int> indices;
+		for (int i = 0; i<num_targets; i++)
 		{
-			result_array = new node_t[result.size()];
-			for (int i = 0; i<result.size(); i++)
-				result_array[i] = result[i];
+			const int v = graph.index(targets[i]);
+			if (v >= 0) indices.push_back(v);
 		}
-		return ::path<node_t, cost_t>(result_array, result.size(), g_score[end]);
+		std::sort(indices.begin(), indices.end());
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+		return indices;
 	}
-	
-	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
-	path<node_t, cost_t> A_star(cost_t** graph, const node_t* verteces, const int num_verteces, const node_t begining, const node_t end)
+
+	// cheapest path from source to target by Dijkstra, that stops once target is settled
+	template<typename node_t, typename cost_t>
+	path<node_t, cost_t> shortest_path(const csr_graph<node_t, cost_t>& graph, const node_t source, const node_t target, const cost_t bound = (cost_t)-1)
 	{
-		int num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i][j]>0) num_edges++;
-		graph_edge<node_t, cost_t>* graph_edges = new graph_edge<node_t, cost_t>[num_edges];
-		num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i][j]>0) 
-					graph_edges[num_edges++] = graph_edge<node_t, cost_t>(verteces[i], verteces[j], graph[i][j]);	
-		return A_star<node_t, cost_t, heuristic>(graph_edges, num_edges, begining, end);
-	}
-	
+		search_workspace<cost_t> workspace;
+		const graph_vertex<node_t, cost_t> seed(source, 0);
+		const int t = graph.index(target);
+		bool found = false;
+		dijkstra_search(graph, workspace, &seed, 1, bound, [&](int v, cost_t){return !(found = (v == t));});
+		return found ? make_path(trace_path(graph, workspace, t), workspace.distance(t)) : path<node_t, cost_t>(NULL, 0, (cost_t)-1);
+	}
+
+	template<typename node_t, typename cost_t>
+	path<node_t, cost_t> bidirectional_dijkstra(const csr_graph<node_t, cost_t>& graph, const csr_graph<node_t, cost_t>& reverse, const node_t source, const node_t target, const cost_t bound = (cost_t)-1)
+	{
+		search_workspace<cost_t> forward, backward;
+		vector<node_t> nodes;
+		const cost_t cost = bidirectional_dijkstra_search(graph, reverse, forward, backward, source, target, bound, nodes);
+		return make_path(nodes, cost);
+	}
+
 	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t)>
-	path<node_t, cost_t> A_star(const cost_t* graph, const node_t* verteces, const int num_verteces, const node_t begining, const node_t end)
+	path<node_t, cost_t> bidirectional_A_star(const csr_graph<node_t, cost_t>& graph, const csr_graph<node_t, cost_t>& reverse, const node_t source, const node_t target, const cost_t bound = (cost_t)-1)
+	{
+		search_workspace<cost_t> forward, backward;
+		vector<node_t> nodes;
+		const cost_t cost = bidirectional_A_star_search<node_t, cost_t, heuristic>(graph, reverse, forward, backward, source, target, bound, nodes);
+		return make_path(nodes, cost);
+	}
+
+	// the k of targets[0..num_targets) closest to source within bound, cheapest first
+	template<typename node_t, typename cost_t>
+	vector<graph_vertex<node_t, cost_t>> nearest_targets(const csr_graph<node_t, cost_t>& graph, const node_t source, const node_t* targets, const int num_targets, const size_t k, const cost_t bound = (cost_t)-1)
 	{
-		int num_edges = 0;
-		for (int i = 0; i<num_verteces*num_verteces; i++)
-			if (graph[i]>0) num_edges++;
-		graph_edge<node_t, cost_t>* graph_edges = new graph_edge<node_t, cost_t>[num_edges];
-		num_edges = 0;
-		for (int i = 0; i<num_verteces; i++)
-			for (int j = 0; j<num_verteces; j++)
-				if (graph[i*num_verteces+j]>0) 
-					graph_edges[num_edges++] = graph_edge<node_t, cost_t>(verteces[i], verteces[j], graph[i*num_verteces+j]);	
-		return A_star<node_t, cost_t, heuristic>(graph_edges, num_edges, begining, end);
+		search_workspace<cost_t> workspace;
+		const graph_vertex<node_t, cost_t> seed(source, 0);
+		return nearest_search(graph, workspace, &seed, 1, target_indices(graph, targets, num_targets), k, bound);
 	}
 
+	/**
+	*	Answers many shortest path queries against one fixed graph. The graph is
+	*	prepared once and searches reuse their workspaces, one per pool thread
+	*	plus spares for direct calls, so a query only allocates its result.
+	*	Every method may be called from several threads at once.
+	*/
+	template<typename node_t, typename cost_t, cost_t (*heuristic)(node_t, node_t) = standard_heuristic<node_t, cost_t>>
+	class ShortestPathEngine {
+	public:
+		// a search to target from any of the seeds, each starting at its own cost
+		struct Query {
+			vector<graph_vertex<node_t, cost_t>> seeds;
+			node_t target;
+			Query(){};
+			Query(const node_t source, const node_t target):seeds(1, graph_vertex<node_t, cost_t>(source, 0)),target(target){};
+			Query(const vector<node_t>& sources, const node_t target):target(target)
+			{
+				for (size_t i = 0; i<sources.size(); i++) seeds.push_back(graph_vertex<node_t, cost_t>(sources[i], 0));
+			};
+			Query(const vector<graph_vertex<node_t, cost_t>>& seeds, const node_t target):seeds(seeds),target(target){};
+		};
+
+		// nodes from a seed to the target, empty with cost -1 if the target cannot be reached
+		struct Route {
+			vector<node_t> nodes;
+			cost_t cost;
+		};
+
+		// threads is the size of the pool for batches, 0 for one per core
+		explicit ShortestPathEngine(const csr_graph<node_t, cost_t>& graph, const unsigned threads = 0):graph(graph),reverse(graph.reversed()),pool(threads),workspaces(pool.threads()){};
+		ShortestPathEngine(const graph_edge<node_t, cost_t>* graph, const int num_edges, const unsigned threads = 0):ShortestPathEngine(csr_graph<node_t, cost_t>(graph, num_edges), threads){};
+
+		const csr_graph<node_t, cost_t>& Graph() const {return graph;}
+		unsigned Threads() const {return pool.threads();}
+
+		// A* that stops at the target and ignores paths costing more than bound
+		Route Path(const Query& query, const cost_t bound = (cost_t)-1)
+		{
+			lease workspace(*this);
+			return route(*workspace, query, bound);
+		}
+
+		// answers the queries across the pool, results in the same order
+		vector<Route> Paths(const vector<Query>& queries, const cost_t bound = (cost_t)-1)
+		{
+			vector<Route> results(queries.size());
+			pool.run(queries.size(), [&](unsigned worker, size_t i){results[i] = route(workspaces[worker], queries[i], bound);});
+			return results;
+		}
+
+		// bidirectional A*, or bidirectional Dijkstra with the standard heuristic
+		Route BidirectionalPath(const node_t source, const node_t target, const cost_t bound = (cost_t)-1)
+		{
+			lease forward(*this), backward(*this);
+			Route result;
+			if (heuristic == &standard_heuristic<node_t, cost_t>)
+				result.cost = bidirectional_dijkstra_search(graph, reverse, *forward, *backward, source, target, bound, result.nodes);
+			else
+				result.cost = bidirectional_A_star_search<node_t, cost_t, heuristic>(graph, reverse, *forward, *backward, source, target, bound, result.nodes);
+			return result;
+		}
+
+		// the k targets closest to the seeds within bound, cheapest first
+		vector<graph_vertex<node_t, cost_t>> Nearest(const vector<graph_vertex<node_t, cost_t>>& seeds, const vector<node_t>& targets, const size_t k, const cost_t bound = (cost_t)-1)
+		{
+			lease workspace(*this);
+			return nearest_search(graph, *workspace, seeds.data(), (int)seeds.size(), target_indices(graph, targets.data(), (int)targets.size()), k, bound);
+		}
+		vector<graph_vertex<node_t, cost_t>> Nearest(const node_t source, const vector<node_t>& targets, const size_t k, const cost_t bound = (cost_t)-1)
+		{
+			return Nearest(vector<graph_vertex<node_t, cost_t>>(1, graph_vertex<node_t, cost_t>(source, 0)), targets, k, bound);
+		}
+
+		// costs from the seeds to every vertex, indexed like Graph().nodes, -1 if unreachable
+		vector<cost_t> Distances(const vector<graph_vertex<node_t, cost_t>>& seeds)
+		{
+			lease workspace(*this);
+			return distances(*workspace, seeds);
+		}
+		vector<cost_t> Distances(const node_t source)
+		{
+			return Distances(vector<graph_vertex<node_t, cost_t>>(1, graph_vertex<node_t, cost_t>(source, 0)));
+		}
+
+		// one Distances result per seed set, computed across the pool
+		vector<vector<cost_t>> Distances(const vector<vector<graph_vertex<node_t, cost_t>>>& batch)
+		{
+			vector<vector<cost_t>> results(batch.size());
+			pool.run(batch.size(), [&](unsigned worker, size_t i){results[i] = distances(workspaces[worker], batch[i]);});
+			return results;
+		}
+
+	private:
+		const csr_graph<node_t, cost_t> graph, reverse;
+		search_pool pool;
+		// workspaces[w] belongs to pool worker w while a batch runs
+		vector<search_workspace<cost_t>> workspaces;
+		std::mutex spare_lock;
+		vector<std::unique_ptr<search_workspace<cost_t>>> spares;
+
+		// a spare workspace checked out for one direct call
+		class lease {
+		public:
+			explicit lease(ShortestPathEngine& engine):engine(engine)
+			{
+				std::lock_guard<std::mutex> guard(engine.spare_lock);
+				if (engine.spares.empty()) workspace.reset(new search_workspace<cost_t>());
+				else
+				{
+					workspace = std::move(engine.spares.back());
+					engine.spares.pop_back();
+				}
+			}
+			~lease()
+			{
+				std::lock_guard<std::mutex> guard(engine.spare_lock);
+				engine.spares.push_back(std::move(workspace));
+			}
+			lease(const lease&) = delete;
+			lease& operator=(const lease&) = delete;
+			search_workspace<cost_t>& operator*() const {return *workspace;}
+
+		private:
+			ShortestPathEngine& engine;
+			std::unique_ptr<search_workspace<cost_t>> workspace;
+		};
+
+		Route route(search_workspace<cost_t>& workspace, const Query& query, const cost_t bound) const
+		{
+			A_star_search<node_t, cost_t, heuristic>(graph, workspace, query.seeds.data(), (int)query.seeds.size(), query.target, bound);
+			Route result;
+			const int t = graph.index(query.target);
+			result.cost = (t >= 0) ? workspace.distance(t) : (cost_t)-1;
+			if (t >= 0 && workspace.reached(t)) result.nodes = trace_path(graph, workspace, t);
+			return result;
+		}
+
+		vector<cost_t> distances(search_workspace<cost_t>& workspace, const vector<graph_vertex<node_t, cost_t>>& seeds) const
+		{
+			dijkstra_search(graph, workspace, seeds.data(), (int)seeds.size());
+			vector<cost_t> result(graph.num_verteces());
+			for (int v = 0; v<graph.num_verteces(); v++) result[v] = workspace.distance(v);
+			return result;
+		}
+	};
+
 }
-#endif
\ No newline at end of file
+#endif
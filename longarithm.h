@@ -2,175 +2,386 @@
 #define LONGARITHMETICS
 
 #include<string>
+#include<string_view>
+#include<algorithm>
+#include<cstring>
 using std::string;
-#define max(x,y) (x)>(y)?(x):(y)
 
 namespace gasper{
-	
-	string reverse(string a)
-	{
-		int k = a.length();
-		for (int i = 0; i<k/2; i++)
-		{
-			char tmp = a[i];
-			a[i] = a[k-i-1];
-			a[k-i-1] = tmp;
+
+	namespace detail {
+
+		/**
+		*	Kernels behind the string API. Numbers are digit strings, most
+		*	significant digit first, and results are written to buffers supplied
+		*	by the caller, so the kernels never allocate. Digits are 0-9 then a-z,
+		*	letters of either case are read, for bases up to 36.
+		*/
+		namespace digits {
+
+			inline unsigned value(char c) { return c <= '9' ? unsigned(c - '0') : unsigned((c | 0x20) - 'a' + 10); }
+			inline char symbol(unsigned d) { return char(d < 10 ? '0' + d : 'a' + d - 10); }
+
+			// a without leading zeros, empty for zero
+			inline std::string_view strip(std::string_view a)
+			{
+				const std::size_t i = a.find_first_not_of(symbol(0));
+				return i == std::string_view::npos ? std::string_view() : a.substr(i);
+			}
+
+			inline int compare(std::string_view a, std::string_view b)
+			{
+				a = strip(a);
+				b = strip(b);
+				if (a.size() != b.size()) return a.size() > b.size() ? 1 : -1;
+				for (std::size_t i = 0; i < a.size(); ++i)
+					if (value(a[i]) != value(b[i])) return value(a[i]) > value(b[i]) ? 1 : -1;
+				return 0;
+			}
+
+			// r[n] = a[n] with letters in canonical lower case
+			inline void copy(char* r, const char* a, std::size_t n, unsigned base)
+			{
+				if (base <= 10)
+					std::memcpy(r, a, n);
+				else
+					for (std::size_t i = 0; i < n; ++i) r[i] = symbol(value(a[i]));
+			}
+
+			// r[rn] += a[an] in place for an <= rn, returns the carry out of r
+			inline unsigned add_in(char* r, std::size_t rn, const char* a, std::size_t an, unsigned base)
+			{
+				unsigned carry = 0;
+				std::size_t i = 0;
+				for (; i < an; ++i)
+				{
+					const unsigned t = value(r[rn - 1 - i]) + value(a[an - 1 - i]) + carry;
+					carry = t >= base;
+					r[rn - 1 - i] = symbol(carry ? t - base : t);
+				}
+				for (; carry && i < rn; ++i)
+				{
+					const unsigned t = value(r[rn - 1 - i]) + 1;
+					carry = t == base;
+					r[rn - 1 - i] = symbol(carry ? 0 : t);
+				}
+				return carry;
+			}
+
+			// r[rn] -= a[an] in place for an <= rn, returns the borrow out of r
+			inline unsigned sub_in(char* r, std::size_t rn, const char* a, std::size_t an, unsigned base)
+			{
+				unsigned borrow = 0;
+				std::size_t i = 0;
+				for (; i < an; ++i)
+				{
+					const unsigned d = value(r[rn - 1 - i]), s = value(a[an - 1 - i]) + borrow;
+					borrow = d < s;
+					r[rn - 1 - i] = symbol(borrow ? d + base - s : d - s);
+				}
+				for (; borrow && i < rn; ++i)
+				{
+					const unsigned d = value(r[rn - 1 - i]);
+					borrow = d == 0;
+					r[rn - 1 - i] = symbol(borrow ? base - 1 : d - 1);
+				}
+				return borrow;
+			}
+
+			// r[max(|a|, |b|) + 1] = a + b, r must not overlap the inputs
+			inline std::size_t add(char* r, std::string_view a, std::string_view b, unsigned base)
+			{
+				if (a.size() < b.size()) std::swap(a, b);
+				copy(r + 1, a.data(), a.size(), base);
+				r[0] = symbol(add_in(r + 1, a.size(), b.data(), b.size(), base));
+				return a.size() + 1;
+			}
+
+			// r[|a|] = a - b for a >= b and |a| >= |b|, r must not overlap the inputs
+			inline std::size_t sub(char* r, std::string_view a, std::string_view b, unsigned base)
+			{
+				copy(r, a.data(), a.size(), base);
+				sub_in(r, a.size(), b.data(), b.size(), base);
+				return a.size();
+			}
+
+			// r[n] *= d in place for d < base, returns the carry digit
+			inline unsigned mul_1(char* r, std::size_t n, unsigned d, unsigned base)
+			{
+				unsigned carry = 0;
+				for (std::size_t i = n; i--; )
+				{
+					const unsigned t = value(r[i]) * d + carry;
+					carry = t / base;
+					r[i] = symbol(t % base);
+				}
+				return carry;
+			}
+
+			// r[n] /= d in place, returns the remainder
+			inline unsigned div_1(char* r, std::size_t n, unsigned d, unsigned base)
+			{
+				unsigned rest = 0;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					const unsigned t = rest * base + value(r[i]);
+					r[i] = symbol(t / d);
+					rest = t % d;
+				}
+				return rest;
+			}
+
+			const std::size_t karatsuba_threshold = 32;
+
+			// digits of scratch mul needs for factors of an and bn digits
+			inline std::size_t mul_scratch(std::size_t an, std::size_t bn) { return 8 * (std::max(an, bn) + karatsuba_threshold); }
+
+			/**
+			*	r[an + bn] = a[an] * b[bn], r must not overlap the factors. Splits the
+			*	longer factor as a1 * base^m + a0; if the shorter one has no high
+			*	part it is multiplied by both halves, otherwise Karatsuba's three
+			*	products are formed in r and scratch.
+			*/
+			inline void mul(char* r, const char* a, std::size_t an, const char* b, std::size_t bn, unsigned base, char* scratch)
+			{
+				if (an < bn)
+				{
+					std::swap(a, b);
+					std::swap(an, bn);
+				}
+				const std::size_t rn = an + bn;
+				if (bn < karatsuba_threshold)
+				{
+					// column by column, so there is one division per result digit
+					unsigned long long acc = 0;
+					for (std::size_t k = 0; k < rn; ++k)
+					{
+						for (std::size_t i = k < an ? 0 : k - an + 1; i <= k && i < bn; ++i)
+							acc += value(b[bn - 1 - i]) * value(a[an - 1 - (k - i)]);
+						r[rn - 1 - k] = symbol(unsigned(acc % base));
+						acc /= base;
+					}
+					return;
+				}
+
+				const std::size_t m = (an + 1) / 2;
+				const char* a0 = a + an - m;
+				if (bn <= m)
+				{
+					// r = a1 * b * base^m + a0 * b
+					char* t = scratch;
+					mul(r + an - m, a0, m, b, bn, base, scratch);
+					std::fill(r, r + an - m, symbol(0));
+					mul(t, a, an - m, b, bn, base, t + an - m + bn);
+					add_in(r, rn - m, t, an - m + bn, base);
+					return;
+				}
+
+				// p0 = a0 * b0 and p2 = a1 * b1 side by side in r
+				const char* b0 = b + bn - m;
+				mul(r + rn - 2 * m, a0, m, b0, m, base, scratch);
+				mul(r, a, an - m, b, bn - m, base, scratch);
+
+				// p1 = (a0 + a1) * (b0 + b1) - p0 - p2 is added in at base^m
+				char* sa = scratch;
+				char* sb = sa + m + 1;
+				char* p1 = sb + m + 1;
+				sa[0] = sb[0] = symbol(0);
+				std::memcpy(sa + 1, a0, m);
+				std::memcpy(sb + 1, b0, m);
+				add_in(sa, m + 1, a, an - m, base);
+				add_in(sb, m + 1, b, bn - m, base);
+				mul(p1, sa, m + 1, sb, m + 1, base, p1 + 2 * m + 2);
+				sub_in(p1, 2 * m + 2, r + rn - 2 * m, 2 * m, base);
+				sub_in(p1, 2 * m + 2, r, rn - 2 * m, base);
+				const std::string_view middle = strip(std::string_view(p1, 2 * m + 2));
+				add_in(r, rn - m, middle.data(), middle.size(), base);
+			}
+
+			// digits of scratch divrem needs for a dividend of an and a divisor of bn digits
+			inline std::size_t divrem_scratch(std::size_t an, std::size_t bn) { return an + bn + 1; }
+
+			/**
+			*	q[an - bn + 1] = a / b and r[bn] = a % b for an >= bn and b without
+			*	leading zeros, by Knuth's algorithm D on digits: both are scaled so
+			*	the top divisor digit is at least base / 2, then every quotient digit
+			*	is estimated from the top two digits of the running remainder,
+			*	corrected with the second divisor digit and is then at most one too
+			*	large. q and r must not overlap the inputs or scratch.
+			*/
+			inline void divrem(char* q, char* r, std::string_view a, std::string_view b, unsigned base, char* scratch)
+			{
+				const std::size_t an = a.size(), bn = b.size();
+				if (bn == 1)
+				{
+					std::memcpy(q, a.data(), an);
+					r[0] = symbol(div_1(q, an, value(b[0]), base));
+					return;
+				}
+
+				const unsigned d = base / (value(b[0]) + 1);
+				char* u = scratch;
+				char* v = u + an + 1;
+				std::memcpy(u + 1, a.data(), an);
+				u[0] = symbol(mul_1(u + 1, an, d, base));
+				std::memcpy(v, b.data(), bn);
+				mul_1(v, bn, d, base);
+
+				const unsigned v0 = value(v[0]), v1 = value(v[1]);
+				for (std::size_t j = 0; j <= an - bn; ++j)
+				{
+					// w[bn + 1] is the running remainder the next digit is taken from
+					char* w = u + j;
+					const unsigned top = value(w[0]) * base + value(w[1]);
+					unsigned qhat = top / v0, rhat = top % v0;
+					while (qhat >= base || qhat * v1 > rhat * base + value(w[2]))
+					{
+						--qhat;
+						rhat += v0;
+						if (rhat >= base) break;
+					}
+
+					unsigned carry = 0, borrow = 0;
+					for (std::size_t i = bn; i--; )
+					{
+						const unsigned p = qhat * value(v[i]) + carry, s = p % base + borrow, x = value(w[i + 1]);
+						carry = p / base;
+						borrow = x < s;
+						w[i + 1] = symbol(borrow ? x + base - s : x - s);
+					}
+					const unsigned s = carry + borrow, x = value(w[0]);
+					w[0] = symbol(x < s ? x + base - s : x - s);
+					if (x < s)
+					{
+						// one too large: add the divisor back, the carry out cancels the wrap
+						--qhat;
+						add_in(w, bn + 1, v, bn, base);
+					}
+					q[j] = symbol(qhat);
+				}
+				std::memcpy(r, u + an + 1 - bn, bn);
+				div_1(r, bn, d, base);
+			}
+
 		}
-		return a;
+
 	}
-	
-	string add(string a, string b, const int base = 10)
+
+	inline string reverse(string a)
 	{
-		if (a.length()==0) return (b.length()==0 ? "0" : b);
-		if (b.length()==0) return a;
-		
-		a = reverse(a);
-		b = reverse(b);
-		
-		unsigned int k = max(a.length(), b.length());
-		for(int i = a.length(); i<k; i++) a+="0";
-		for(int i = b.length(); i<k; i++) b+="0";
-		
-		int p = 0;
-		string result = "";
-		for(int i = 0; i<k; i++)
-		{
-			unsigned int tmp = (a[i]-48)+(b[i]-48)+p;
-			result += tmp%base + 48;
-			p = tmp/base;
-		}
-		if (p) result += p + 48;
-		return reverse(result);
+		std::reverse(a.begin(), a.end());
+		return a;
 	}
 
-	string delz(string a)
+	inline string delz(string a)
 	{
-		while(true)
-			if (a[0]==48) 
-				a = a.substr(1,a.length());
-			else break;
+		a.erase(0, std::min(a.find_first_not_of('0'), a.size()));
 		return a.length() ? a : "0";
 	}
 
-	int cmp(string a, string b)
+	inline int cmp(std::string_view a, std::string_view b)
 	{
-		a = delz(a);
-		b = delz(b);
-		if (a.length()!=b.length()) return (a.length()>b.length()?1:-1);
-	
-		for (int i = 0; i<a.length(); i++)
-		{
-			if (a[i]!=b[i]) return (a[i]>b[i]?1:-1);
-		}
-		return 0;
+		return detail::digits::compare(a, b);
 	}
-	
-	string sub(string a, string b, const int base = 10)
+
+	inline string add(std::string_view a, std::string_view b, const int base = 10)
 	{
-		if (!cmp(a,b)) return "0";
-		if (cmp(a,b)<0) return "Error: first argument must be greater or equal to second.";
-	
-		a = reverse(a);
-		b = reverse(b);
-		
-		unsigned int k = max(a.length(), b.length());
-		for(int i = a.length(); i<k; i++) a+="0";
-		for(int i = b.length(); i<k; i++) b+="0";
-		
-		string result = "";
-		for (int i = 0; i<k; i++)
-		{
-			int diff = a[i]-b[i];
-			if (diff>=0)
-				result += diff + 48;
-			else
-			{
-				int j = i+1;
-				while(j<=k)
-				{
-					a[j] = (a[j]-48+(base-1))%base + 48;
-					if (a[j]-48 == base-1)
-						j++;
-					else 
-						break;
-				}
-				result += diff+base+48;
-			}
-		}
-		
-		return delz(reverse(result));
+		if (a.empty()) return b.empty() ? "0" : add("0", b, base);
+		if (b.empty()) return add(a, "0", base);
+
+		string result(std::max(a.size(), b.size()) + 1, '0');
+		detail::digits::add(&result[0], a, b, base);
+		if (result[0] == '0') result.erase(0, 1);
+		return result;
 	}
-	
-	string mul(string a, string b, const int base = 10)
+
+	inline string sub(std::string_view a, std::string_view b, const int base = 10)
 	{
-		if (a.length()==0 || b.length()==0) return "0";
-		
-		unsigned int k = max(a.length(), b.length());
-		for(int i = a.length(); i<k; i++) a="0"+a;
-		for(int i = b.length(); i<k; i++) b="0"+b;
-		
-		int res = 0;
-		string result = "";
-		if (k == 1)
-		{
-			res = (a[0]-48)*(b[0]-48);
-			if (res<base)
-				result += (char)res+48;
-			else
-			{
-				result += (char)(res/base+48);
-				result += (char)(res%base+48);
-			}
-			return result;
-		}
-		
-		unsigned int m0 = (k+1)/2;
-		string	x1 = a.substr(m0, k-m0),
-				x0 = a.substr(0, m0),
-				y1 = b.substr(m0, k-m0),
-				y0 = b.substr(0, m0);
-		string	p0 = mul(x0,y0,base),
-				p1 = mul(add(x0,x1,base), add(y0,y1,base), base),
-				p2 = mul(x1,y1,base);
-		string z = sub(p1, add(p0,p2,base), base);
-		for(int i = 0; i<k/2; i++)
-		{
-			p0+="00";
-			z+="0";
-		}
-		
-		return delz(add(add(p0,z,base), p2, base));
+		const int c = cmp(a, b);
+		if (!c) return "0";
+		if (c < 0) return "Error: first argument must be greater or equal to second.";
+
+		a = detail::digits::strip(a);
+		b = detail::digits::strip(b);
+		string result(a.size(), '0');
+		detail::digits::sub(&result[0], a, b, base);
+		return delz(std::move(result));
 	}
-	
-	string inc(string a, const string increment = "1", const int base = 10)
+
+	inline string mul(std::string_view a, std::string_view b, const int base = 10)
+	{
+		a = detail::digits::strip(a);
+		b = detail::digits::strip(b);
+		if (a.empty() || b.empty()) return "0";
+
+		// the scratch lives behind the product and is cut off afterwards
+		const std::size_t n = a.size() + b.size();
+		string result(n + detail::digits::mul_scratch(a.size(), b.size()), '0');
+		detail::digits::mul(&result[0], a.data(), a.size(), b.data(), b.size(), base, &result[n]);
+		result.resize(n);
+		return delz(std::move(result));
+	}
+
+	inline string inc(std::string_view a, std::string_view increment = "1", const int base = 10)
 	{
 		return add(a, increment, base);
 	}
-	
-	string dec(string a, const string decrement = "1", const int base = 10)
+
+	inline string dec(std::string_view a, std::string_view decrement = "1", const int base = 10)
 	{
 		return sub(a, decrement, base);
 	}
-	
-	string div(string a, string b, const int base = 10)
+
+	/**
+	*	quotient = a / b and remainder = a % b by long division, computed
+	*	together. A zero divisor sets both to the error message div and mod
+	*	return for it.
+	*/
+	inline void divmod(std::string_view a, std::string_view b, string& quotient, string& remainder, const int base = 10)
+	{
+		a = detail::digits::strip(a);
+		b = detail::digits::strip(b);
+		if (a.empty())
+		{
+			quotient = remainder = "0";
+			return;
+		}
+		if (b.empty())
+		{
+			quotient = remainder = "Error: division by zero.";
+			return;
+		}
+		if (detail::digits::compare(a, b) < 0)
+		{
+			quotient = "0";
+			remainder.resize(a.size());
+			detail::digits::copy(&remainder[0], a.data(), a.size(), base);
+			return;
+		}
+
+		// the scratch lives behind the remainder and is cut off afterwards
+		quotient.assign(a.size() - b.size() + 1, '0');
+		remainder.assign(b.size() + detail::digits::divrem_scratch(a.size(), b.size()), '0');
+		detail::digits::divrem(&quotient[0], &remainder[0], a, b, base, &remainder[b.size()]);
+		remainder.resize(b.size());
+		quotient = delz(std::move(quotient));
+		remainder = delz(std::move(remainder));
+	}
+
+	inline string div(std::string_view a, std::string_view b, const int base = 10)
 	{
-		if (a.length() == 0 || (a = delz(a)) == "0") return "0";
-		if (b.length() == 0 || (b = delz(b)) == "0") return "Error: division by zero.";
-		if (cmp(a,b)<0) return "0";
-		string div = "0";
-		while (cmp((a = sub(a,b,base)), b)>=0)
-			div = inc(div, "1", base);
-		return inc(div, "1", base);
+		string quotient, remainder;
+		divmod(a, b, quotient, remainder, base);
+		return quotient;
 	}
-	
-	string mod(string a, string b, const int base = 10)
+
+	inline string mod(std::string_view a, std::string_view b, const int base = 10)
 	{
-		if (a.length() == 0 || (a = delz(a)) == "0") return "0";
-		if (b.length() == 0 || (b = delz(b)) == "0") return "Error: division by zero.";
-		while (cmp((a = sub(a,b,base)), b)>=0);
-		return a;
+		string quotient, remainder;
+		divmod(a, b, quotient, remainder, base);
+		return remainder;
 	}
-	
+
 }
 
-#endif
\ No newline at end of file
+#endif
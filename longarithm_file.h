@@ -0,0 +1,292 @@
+#ifndef LONGARITHMETICS_FILE
+#define LONGARITHMETICS_FILE
+
+#include "longarithm.h"
+#include<stdexcept>
+#include<vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#endif
+
+namespace gasper{
+
+	namespace detail {
+
+		/**
+		*	A file mapped into memory, either read-only or created for writing
+		*	with a given size. Pages that are done with can be released so the
+		*	working set stays bounded while streaming over files of any size.
+		*/
+		class mapped_file
+		{
+		public:
+			explicit mapped_file(const string& path) : path(path)
+			{
+				Open(false, 0);
+			}
+			mapped_file(const string& path, std::size_t size) : path(path)
+			{
+				Open(true, size);
+			}
+			~mapped_file() { close(); }
+			mapped_file(const mapped_file&) = delete;
+			mapped_file& operator=(const mapped_file&) = delete;
+
+			inline char* data() const { return bytes; }
+			inline std::size_t size() const { return length; }
+
+			// drops the whole pages within [offset, offset + len) from the working set
+			void release(std::size_t offset, std::size_t len)
+			{
+#if defined(_WIN32)
+				(void)offset;
+				(void)len;
+#else
+				const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+				const std::size_t begin = (offset + page - 1) / page * page, end = (offset + len) / page * page;
+				if (bytes && begin < end) madvise(bytes + begin, end - begin, MADV_DONTNEED);
+#endif
+			}
+
+			// unmaps the file; a written file is cut to its first keep bytes
+			void close(std::size_t keep = string::npos)
+			{
+#if defined(_WIN32)
+				if (bytes) UnmapViewOfFile(bytes);
+				if (file != INVALID_HANDLE_VALUE)
+				{
+					LARGE_INTEGER end;
+					end.QuadPart = LONGLONG(std::min(keep, length));
+					if (writable && (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file))) keep = 0;
+					CloseHandle(file);
+				}
+				file = INVALID_HANDLE_VALUE;
+#else
+				if (bytes) munmap(bytes, length);
+				if (file >= 0)
+				{
+					if (writable && ftruncate(file, off_t(std::min(keep, length))) != 0) keep = 0;
+					::close(file);
+				}
+				file = -1;
+#endif
+				bytes = nullptr;
+				length = 0;
+			}
+
+		private:
+			string path;
+			char* bytes = nullptr;
+			std::size_t length = 0;
+			bool writable = false;
+#if defined(_WIN32)
+			HANDLE file = INVALID_HANDLE_VALUE;
+#else
+			int file = -1;
+#endif
+
+			void Open(bool write, std::size_t size)
+			{
+				writable = write;
+#if defined(_WIN32)
+				file = write ? CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)
+					: CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path + ".");
+				LARGE_INTEGER fileSize;
+				fileSize.QuadPart = LONGLONG(size);
+				if (write ? !SetFilePointerEx(file, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(file) : !GetFileSizeEx(file, &fileSize))
+				{
+					close();
+					throw std::runtime_error("Cannot size " + path + ".");
+				}
+				length = std::size_t(fileSize.QuadPart);
+				if (!length) return;
+				HANDLE mapping = CreateFileMappingA(file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+				if (mapping)
+				{
+					bytes = static_cast<char*>(MapViewOfFile(mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+					CloseHandle(mapping);
+				}
+#else
+				file = write ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+				if (file < 0) throw std::runtime_error("Cannot open " + path + ".");
+				struct stat info;
+				if (write ? ftruncate(file, off_t(size)) != 0 : fstat(file, &info) != 0)
+				{
+					close();
+					throw std::runtime_error("Cannot size " + path + ".");
+				}
+				length = write ? size : std::size_t(info.st_size);
+				if (!length) return;
+				void* p = mmap(nullptr, length, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+				if (p != MAP_FAILED) bytes = static_cast<char*>(p);
+#endif
+				if (!bytes)
+				{
+					close();
+					throw std::runtime_error("Cannot map " + path + ".");
+				}
+			}
+		};
+
+		// digits of a mapped digit file, without leading zeros and trailing whitespace
+		inline std::string_view file_digits(const mapped_file& f)
+		{
+			std::string_view digits(f.data(), f.size());
+			const std::size_t end = digits.find_last_not_of(" \t\r\n");
+			return digits::strip(digits.substr(0, end == std::string_view::npos ? 0 : end + 1));
+		}
+
+		// digits streamed through memory at a time by the file operations
+		const std::size_t file_block = std::size_t(1) << 20;
+
+		// moves out[from, size) to the front in blocks, leaving "0" for an all-zero result, and closes out
+		inline void finish_file(mapped_file& out, std::size_t from)
+		{
+			const std::size_t n = out.size() - from;
+			if (!n)
+			{
+				if (out.size()) out.data()[0] = digits::symbol(0);
+				out.close(1);
+				return;
+			}
+			for (std::size_t i = 0; from && i < n; i += file_block)
+			{
+				const std::size_t len = std::min(file_block, n - i);
+				std::memmove(out.data() + i, out.data() + from + i, len);
+				out.release(i, from + len);
+			}
+			out.close(n);
+		}
+
+		// number of leading zero digits of the mapped output
+		inline std::size_t leading_zero_digits(const mapped_file& out)
+		{
+			const std::size_t i = std::string_view(out.data(), out.size()).find_first_not_of(digits::symbol(0));
+			return i == std::string_view::npos ? out.size() : i;
+		}
+
+	}
+
+	/**
+	*	Out-of-core variants of add, sub and mul. Operands are files holding
+	*	the digits as text, most significant first, that are mapped rather than
+	*	read; the result is written to a mapped output file. Addition and
+	*	subtraction walk the files from the back in blocks, multiplication forms
+	*	products of digit blocks in memory and accumulates them into the output
+	*	one block column at a time, releasing finished pages as it goes, so the
+	*	memory used stays bounded by the block sizes, not the operands.
+	*/
+	inline void add_file(const string& a, const string& b, const string& result, const int base = 10)
+	{
+		detail::mapped_file fa(a), fb(b);
+		std::string_view x = detail::file_digits(fa), y = detail::file_digits(fb);
+		if (x.size() < y.size()) std::swap(x, y);
+
+		detail::mapped_file out(result, x.size() + 1);
+		char* r = out.data() + 1;
+		const char one = detail::digits::symbol(1);
+		unsigned carry = 0;
+		for (std::size_t done = 0; done < x.size(); done += detail::file_block)
+		{
+			const std::size_t len = std::min(detail::file_block, x.size() - done), begin = x.size() - done - len;
+			detail::digits::copy(r + begin, x.data() + begin, len, base);
+			const std::size_t ylen = done < y.size() ? std::min(len, y.size() - done) : 0;
+			const char* yblock = ylen ? y.data() + y.size() - done - ylen : y.data();
+			unsigned c = detail::digits::add_in(r + begin, len, yblock, ylen, base);
+			if (carry) c += detail::digits::add_in(r + begin, len, &one, 1, base);
+			carry = c;
+			out.release(begin + 1, len);
+			fa.release(std::size_t(x.data() + begin - fa.data()), len);
+			if (ylen) fb.release(std::size_t(yblock - fb.data()), ylen);
+		}
+		out.data()[0] = detail::digits::symbol(carry);
+		detail::finish_file(out, detail::leading_zero_digits(out));
+	}
+
+	// result = a - b, throws if a < b
+	inline void sub_file(const string& a, const string& b, const string& result, const int base = 10)
+	{
+		detail::mapped_file fa(a), fb(b);
+		const std::string_view x = detail::file_digits(fa), y = detail::file_digits(fb);
+		if (detail::digits::compare(x, y) < 0)
+			throw std::invalid_argument("First argument must be greater or equal to second.");
+
+		detail::mapped_file out(result, std::max<std::size_t>(x.size(), 1));
+		out.data()[0] = detail::digits::symbol(0);
+		const char one = detail::digits::symbol(1);
+		unsigned borrow = 0;
+		for (std::size_t done = 0; done < x.size(); done += detail::file_block)
+		{
+			const std::size_t len = std::min(detail::file_block, x.size() - done), begin = x.size() - done - len;
+			detail::digits::copy(out.data() + begin, x.data() + begin, len, base);
+			const std::size_t ylen = done < y.size() ? std::min(len, y.size() - done) : 0;
+			const char* yblock = ylen ? y.data() + y.size() - done - ylen : y.data();
+			unsigned b = detail::digits::sub_in(out.data() + begin, len, yblock, ylen, base);
+			if (borrow) b += detail::digits::sub_in(out.data() + begin, len, &one, 1, base);
+			borrow = b;
+			out.release(begin, len);
+			fa.release(std::size_t(x.data() + begin - fa.data()), len);
+			if (ylen) fb.release(std::size_t(yblock - fb.data()), ylen);
+		}
+		detail::finish_file(out, detail::leading_zero_digits(out));
+	}
+
+	// result = a * b, multiplying blockDigits-digit pieces in memory
+	inline void mul_file(const string& a, const string& b, const string& result, const int base = 10, std::size_t blockDigits = std::size_t(1) << 14)
+	{
+		detail::mapped_file fa(a), fb(b);
+		const std::string_view x = detail::file_digits(fa), y = detail::file_digits(fb);
+		if (x.empty() || y.empty())
+		{
+			detail::mapped_file out(result, 1);
+			detail::finish_file(out, 1);
+			return;
+		}
+
+		const std::size_t n = x.size() + y.size(), block = std::max<std::size_t>(blockDigits, 1);
+		const std::size_t xb = (x.size() + block - 1) / block, yb = (y.size() + block - 1) / block;
+		detail::mapped_file out(result, n);
+		std::size_t zeroed = 0;
+		std::vector<char> product(2 * block + detail::digits::mul_scratch(block, block));
+
+		// block i counts from the least significant end, column k gathers the products with i + j = k
+		auto piece = [block](std::string_view v, std::size_t i)
+		{
+			const std::size_t end = v.size() - i * block;
+			return v.substr(end > block ? end - block : 0, std::min(block, end));
+		};
+		for (std::size_t k = 0; k < xb + yb - 1; ++k)
+		{
+			// the sum of all products so far stays below base^((k + 2) * block + 64), carries never get further
+			const std::size_t reach = std::min(n, (k + 2) * block + 64);
+			std::fill(out.data() + n - reach, out.data() + n - zeroed, detail::digits::symbol(0));
+			zeroed = std::max(zeroed, reach);
+			for (std::size_t i = k < yb ? 0 : k - yb + 1; i <= k && i < xb; ++i)
+			{
+				const std::string_view p = piece(x, i), q = piece(y, k - i);
+				const std::size_t len = p.size() + q.size();
+				detail::digits::mul(product.data(), p.data(), p.size(), q.data(), q.size(), base, product.data() + len);
+				const std::string_view digits = detail::digits::strip(std::string_view(product.data(), len));
+				detail::digits::add_in(out.data(), n - k * block, digits.data(), digits.size(), base);
+				fa.release(std::size_t(p.data() - fa.data()), p.size());
+				fb.release(std::size_t(q.data() - fb.data()), q.size());
+			}
+			// later columns only add at or above block k + 1
+			out.release(n - std::min(n, (k + 1) * block), std::min(block, n - k * block));
+		}
+		detail::finish_file(out, detail::leading_zero_digits(out));
+	}
+
+}
+
+#endif